@@ -0,0 +1,444 @@
+// jios-bench: per-value fixed costs of jios layers
+//
+// Each case runs the same work through a jios layer and through a
+// hand-written baseline, reporting nanoseconds per value for both.
+// Tapes are used as back-end so that front-end and dispatch costs
+// dominate. Build with CMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.pb.h>
+#include <jios/express.hpp>
+#include <jios/json_out.hpp>
+#include <jios/protobuf_ij.hpp>
+#include <jios/protobuf_oj.hpp>
+#include <jios/tape_backend.hpp>
+
+using namespace std;
+using namespace jios;
+
+namespace {
+
+
+//! Keep the compiler from discarding results
+volatile uint64_t sink;
+
+//! ostream discarding output
+class null_streambuf : public streambuf
+{
+protected:
+  int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+  streamsize xsputn(char const*, streamsize n) override { return n; }
+};
+
+struct bench_case
+{
+  string name;
+  size_t values;                  // values processed per run
+  function<uint64_t()> jios;
+  function<uint64_t()> baseline;
+};
+
+double ns_per_value(function<uint64_t()> const& run, size_t values,
+                    double min_seconds)
+{
+  typedef chrono::steady_clock clock;
+  sink = run(); // warm up
+  size_t runs = 0;
+  clock::time_point start = clock::now();
+  chrono::duration<double> elapsed;
+  do {
+    sink = run();
+    ++runs;
+    elapsed = clock::now() - start;
+  } while (elapsed.count() < min_seconds);
+  return elapsed.count() * 1e9 / (double(runs) * values);
+}
+
+size_t const n_values = 100000;
+
+// front-end iteration: ijstreamoid extract/unexpire
+
+bench_case extract_case()
+{
+  auto p_tape = make_shared<tape>();
+  {
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_values; ++i) { oja << int64_t(i); }
+    oja.terminate();
+  }
+  bench_case c;
+  c.name = "ijarray >> int64_t";
+  c.values = n_values;
+  c.jios = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    int64_t v;
+    while (!ija.at_end()) { ija >> v; sum += v; }
+    return sum;
+  };
+  c.baseline = [p_tape]() {
+    uint64_t sum = 0;
+    vector<tape::word> const& w = p_tape->words();
+    size_t end = tape::payload_of(w[0]);
+    for (size_t i = 1; i < end; i += 2) {
+      int64_t v;
+      memcpy(&v, &w[i + 1], sizeof(v));
+      sum += v;
+    }
+    return sum;
+  };
+  return c;
+}
+
+// virtual dispatch of ijvalue::read versus static dispatch
+
+bench_case read_dispatch_case()
+{
+  auto p_tape = make_shared<tape>();
+  {
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_values; ++i) { oja << double(i) / 4; }
+    oja.terminate();
+  }
+  bench_case c;
+  c.name = "ijvalue::read(double) vs static";
+  c.values = n_values;
+  c.jios = [p_tape]() {
+    double sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    double v;
+    while (!ija.at_end()) { ija.get().read(v); sum += v; }
+    return uint64_t(sum);
+  };
+  c.baseline = [p_tape]() {
+    double sum = 0;
+    static_tape_ijstream ija = static_tape_in(*p_tape).array();
+    double v;
+    while (!ija.at_end()) { ija >> v; sum += v; }
+    return uint64_t(sum);
+  };
+  return c;
+}
+
+// ojstream::operator << into a tape
+
+bench_case write_case()
+{
+  bench_case c;
+  c.name = "ojarray << int64_t";
+  c.values = n_values;
+  auto p_tape = make_shared<tape>();
+  c.jios = [p_tape]() {
+    p_tape->clear();
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_values; ++i) { oja << int64_t(i); }
+    oja.terminate();
+    return uint64_t(p_tape->words().size());
+  };
+  auto p_words = make_shared<vector<tape::word>>();
+  c.baseline = [p_words]() {
+    p_words->clear();
+    p_words->push_back(tape::make_word(tape::tag::array));
+    for (size_t i = 0; i < n_values; ++i) {
+      p_words->push_back(tape::make_word(tape::tag::integer));
+      p_words->push_back(tape::word(i));
+    }
+    p_words->push_back(tape::make_word(tape::tag::end, n_values));
+    return uint64_t(p_words->size());
+  };
+  return c;
+}
+
+// sink allocation of sub-structures in make_sub_struct
+
+bench_case sub_struct_case()
+{
+  bench_case c;
+  c.name = "json_out empty array";
+  c.values = n_values;
+  auto p_buf = make_shared<null_streambuf>();
+  c.jios = [p_buf]() {
+    ostream os(p_buf.get());
+    ojstream out = json_out(os);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_values; ++i) {
+      ojarray sub = oja->array();
+      sub.terminate();
+    }
+    oja.terminate();
+    return uint64_t(os.good());
+  };
+  c.baseline = [p_buf]() {
+    ostream os(p_buf.get());
+    os << '[';
+    for (size_t i = 0; i < n_values; ++i) {
+      if (i) os << ',';
+      os << "[]";
+    }
+    os << ']';
+    return uint64_t(os.good());
+  };
+  return c;
+}
+
+// member matching of jobject_reader
+
+struct record
+  : private jobject_expressible<record>
+{
+  int64_t id;
+  string name;
+  double score;
+  bool active;
+  int64_t group;
+  string tag;
+
+  template<class Expression>
+  static void jios_express(Expression & exp)
+  {
+    exp.member("id", &record::id)
+       .member("name", &record::name)
+       .member("score", &record::score)
+       .member("active", &record::active)
+       .member("group", &record::group)
+       .member("tag", &record::tag);
+  }
+};
+
+size_t const n_records = n_values / 6;
+
+shared_ptr<tape> record_tape()
+{
+  auto p_tape = make_shared<tape>();
+  ojstream out = tape_out(*p_tape);
+  ojarray oja = out.put().array();
+  for (size_t i = 0; i < n_records; ++i) {
+    ojobject ojo = oja->object();
+    ojo << make_pair("id", int64_t(i))
+        << make_pair("name", "n")
+        << make_pair("score", 0.5)
+        << make_pair("active", true)
+        << make_pair("group", int64_t(i % 7))
+        << make_pair("tag", "t");
+    ojo.terminate();
+  }
+  oja.terminate();
+  return p_tape;
+}
+
+bench_case member_case()
+{
+  auto p_tape = record_tape();
+  bench_case c;
+  c.name = "jobject_reader::member";
+  c.values = n_records * 6;
+  c.jios = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    record r;
+    while (!ija.at_end()) { ija >> r; sum += r.group; }
+    return sum;
+  };
+  c.baseline = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    record r;
+    while (!ija.at_end()) {
+      ijobject ijo = ija.get().object();
+      while (!ijo.at_end()) {
+        ijpair & v = ijo.get();
+        string key = v.key();
+        if (key == "id") v.read(r.id);
+        else if (key == "name") v.read(r.name);
+        else if (key == "score") v.read(r.score);
+        else if (key == "active") v.read(r.active);
+        else if (key == "group") v.read(r.group);
+        else if (key == "tag") v.read(r.tag);
+      }
+      sum += r.group;
+    }
+    return sum;
+  };
+  return c;
+}
+
+bench_case compiled_member_case()
+{
+  bench_case c = member_case();
+  c.name = "jobject_compiled_reader::member";
+  shared_ptr<tape> p_tape = record_tape();
+  c.jios = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    record r;
+    while (!ija.at_end()) {
+      jobject_compiled_reader<record>::read(ija.get(), r);
+      sum += r.group;
+    }
+    return sum;
+  };
+  return c;
+}
+
+// protobuf reflection field lookup
+
+typedef google::protobuf::FieldDescriptorProto proto_record;
+
+bench_case protobuf_read_case()
+{
+  auto p_tape = make_shared<tape>();
+  {
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_records; ++i) {
+      ojobject ojo = oja->object();
+      ojo << make_pair("name", "field")
+          << make_pair("number", int64_t(i % 1000))
+          << make_pair("type_name", ".pkg.Type")
+          << make_pair("json_name", "field")
+          << make_pair("default_value", "0")
+          << make_pair("proto3_optional", true);
+      ojo.terminate();
+    }
+    oja.terminate();
+  }
+  bench_case c;
+  c.name = "protobuf read";
+  c.values = n_records * 6;
+  c.jios = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    proto_record pro;
+    while (!ija.at_end()) { ija >> pro; sum += pro.number(); }
+    return sum;
+  };
+  c.baseline = [p_tape]() {
+    uint64_t sum = 0;
+    ijarray ija = tape_in(*p_tape).get().array();
+    proto_record pro;
+    string s;
+    int32_t i;
+    bool b;
+    while (!ija.at_end()) {
+      pro.Clear();
+      ijobject ijo = ija.get().object();
+      while (!ijo.at_end()) {
+        ijpair & v = ijo.get();
+        string key = v.key();
+        if (key == "name") { v.read(s); pro.set_name(s); }
+        else if (key == "number") { v.read(i); pro.set_number(i); }
+        else if (key == "type_name") { v.read(s); pro.set_type_name(s); }
+        else if (key == "json_name") { v.read(s); pro.set_json_name(s); }
+        else if (key == "default_value") {
+          v.read(s);
+          pro.set_default_value(s);
+        }
+        else if (key == "proto3_optional") {
+          v.read(b);
+          pro.set_proto3_optional(b);
+        }
+      }
+      sum += pro.number();
+    }
+    return sum;
+  };
+  return c;
+}
+
+bench_case protobuf_write_case()
+{
+  auto p_pro = make_shared<proto_record>();
+  p_pro->set_name("field");
+  p_pro->set_number(7);
+  p_pro->set_type_name(".pkg.Type");
+  p_pro->set_json_name("field");
+  p_pro->set_default_value("0");
+  p_pro->set_proto3_optional(true);
+  auto p_tape = make_shared<tape>();
+  bench_case c;
+  c.name = "protobuf write";
+  c.values = n_records * 6;
+  c.jios = [p_pro, p_tape]() {
+    p_tape->clear();
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < n_records; ++i) { oja << *p_pro; }
+    oja.terminate();
+    return uint64_t(p_tape->words().size());
+  };
+  c.baseline = [p_pro, p_tape]() {
+    p_tape->clear();
+    ojstream out = tape_out(*p_tape);
+    ojarray oja = out.put().array();
+    proto_record const& pro = *p_pro;
+    for (size_t i = 0; i < n_records; ++i) {
+      ojobject ojo = oja->object();
+      ojo << make_pair("name", pro.name())
+          << make_pair("number", int64_t(pro.number()))
+          << make_pair("type_name", pro.type_name())
+          << make_pair("json_name", pro.json_name())
+          << make_pair("default_value", pro.default_value())
+          << make_pair("proto3_optional", pro.proto3_optional());
+      ojo.terminate();
+    }
+    oja.terminate();
+    return uint64_t(p_tape->words().size());
+  };
+  return c;
+}
+
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  double min_seconds = 0.2;
+  string filter;
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "--min-time" && i + 1 < argc) {
+      min_seconds = atof(argv[++i]);
+    } else if (arg == "-h" || arg == "--help") {
+      cout << "usage: jios-bench [--min-time SECONDS] [FILTER]\n";
+      return EXIT_SUCCESS;
+    } else {
+      filter = arg;
+    }
+  }
+
+  vector<bench_case> cases;
+  cases.push_back(extract_case());
+  cases.push_back(read_dispatch_case());
+  cases.push_back(write_case());
+  cases.push_back(sub_struct_case());
+  cases.push_back(member_case());
+  cases.push_back(compiled_member_case());
+  cases.push_back(protobuf_read_case());
+  cases.push_back(protobuf_write_case());
+
+  cout << left << setw(34) << "case"
+       << right << setw(12) << "jios ns"
+       << setw(12) << "base ns"
+       << setw(10) << "ratio" << '\n';
+  cout << fixed << setprecision(2);
+  for (bench_case const& c : cases) {
+    if (c.name.find(filter) == string::npos) continue;
+    double j = ns_per_value(c.jios, c.values, min_seconds);
+    double b = ns_per_value(c.baseline, c.values, min_seconds);
+    cout << left << setw(34) << c.name
+         << right << setw(12) << j
+         << setw(12) << b
+         << setw(10) << (b > 0 ? j / b : 0) << endl;
+  }
+  return EXIT_SUCCESS;
+}
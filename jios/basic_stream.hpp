@@ -0,0 +1,379 @@
+#ifndef JIOS_BASIC_STREAM_HPP
+#define JIOS_BASIC_STREAM_HPP
+
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <jios/express.hpp>
+
+namespace jios {
+
+
+//! Statically dispatched front-ends binding a concrete back-end at
+//! compile time so hot read and write loops can be fully inlined.
+//! Back-end classes should be final. Scalars, strings and types deriving
+//! from jobject_expressible or jobject_compiled_expressible are read and
+//! written directly by the back-end, recursing into expressible members.
+//! Reads of jobject_sparse_expressible types are also direct. Other types
+//! go through the usual jios_read and jios_write customization points.
+//! Only the tape back-end (jios/tape_backend.hpp) provides a Source and
+//! Sink; text back-ends are type-erased only.
+//!
+//! Source must be an ijsource providing:
+//!   typedef ... value_type;        // final ijpair
+//!   value_type & value();          // current value
+//!   bool at_terminator();          // end reached or failed
+//!   void next();
+//! and value_type must provide:
+//!   bool parse(int64_t &), parse(double &), parse(bool &),
+//!        parse(std::string &)      // set failbit and return false
+//!                                  // on type mismatch
+//!   std::shared_ptr<Source> sub_source(bool object);
+//!
+//! Sink must be an ojsink providing:
+//!   print_null(), print(int64_t), print(double), print(bool),
+//!   print_string(char const*, size_t), set_key(char const*, size_t),
+//!   std::shared_ptr<Sink> begin_array(bool), begin_object(bool),
+//!   terminate()
+
+namespace detail {
+
+template<class Value>
+void static_read(Value & v, int64_t & dest) { v.parse(dest); }
+
+template<class Value>
+void static_read(Value & v, double & dest) { v.parse(dest); }
+
+template<class Value>
+void static_read(Value & v, bool & dest) { v.parse(dest); }
+
+template<class Value>
+void static_read(Value & v, std::string & dest) { v.parse(dest); }
+
+template<class Value>
+void static_read(Value & v, int32_t & dest)
+{
+  typedef std::numeric_limits<int32_t> numeric;
+  int64_t tmp;
+  if (v.parse(tmp)) {
+    if (tmp < numeric::min() || tmp > numeric::max()) {
+      v.set_failbit();
+    } else {
+      dest = int32_t(tmp);
+    }
+  }
+}
+
+template<class Value, class T>
+void static_read(Value & v, T & dest);
+
+//! Reads members of an expressible type with static_read, failing on
+//! unknown keys like jobject_reader
+
+template<class Source, class T>
+class static_object_reader
+{
+public:
+  static_object_reader(Source & src, T & dest)
+    : src_(src)
+    , dest_(dest)
+    , found_(false)
+  {}
+
+  //! Read the current member of src, returning false on unknown key
+  bool read_member()
+  {
+    key_ = src_.value().key();
+    found_ = false;
+    T::jios_express(*this);
+    return found_;
+  }
+
+  template<class MemberT, class BaseT,
+           class = EnabledIfIsBaseOf<BaseT, T>>
+  static_object_reader & member(std::string const& key,
+                                MemberT BaseT::*mptr)
+  {
+    if (!found_ && key_ == key) {
+      found_ = true;
+      BaseT & base = dest_;
+      static_read(src_.value(), base.*mptr);
+    }
+    return *this;
+  }
+
+private:
+  Source & src_;
+  T & dest_;
+  std::string key_;
+  bool found_;
+};
+
+template<class Value, class T>
+void static_read_expressed(Value & v, T & dest, std::true_type)
+{
+  jobject_clearer<T>::clear(dest);
+  auto p_src = v.sub_source(true);
+  typedef typename decltype(p_src)::element_type source_type;
+  static_object_reader<source_type, T> reader(*p_src, dest);
+  while (!p_src->at_terminator()) {
+    if (!reader.read_member()) {
+      v.set_failbit();
+      break;
+    }
+    p_src->next();
+  }
+}
+
+template<class Value, class T>
+void static_read_expressed(Value & v, T & dest, std::false_type)
+{
+  ijvalue & ij = v;
+  ij.read(dest);
+}
+
+template<class Value, class T>
+void static_read(Value & v, T & dest)
+{
+  static_read_expressed(v, dest, is_jobject_expressed<T>());
+}
+
+template<class Sink>
+void static_write(Sink & s, std::nullptr_t, ojstream &) { s.print_null(); }
+
+template<class Sink>
+void static_write(Sink & s, bool src, ojstream &) { s.print(src); }
+
+template<class Sink>
+void static_write(Sink & s, std::string const& src, ojstream &)
+{
+  s.print_string(src.data(), src.size());
+}
+
+template<class Sink>
+void static_write(Sink & s, char const* src, ojstream &)
+{
+  s.print_string(src, std::strlen(src));
+}
+
+template<class Wide, class Sink, class T>
+void static_write_arithmetic(Sink & s, T const& src, ojstream &,
+                             std::true_type)
+{
+  s.print(Wide(src));
+}
+
+template<class Wide, class Sink, class T>
+void static_write_arithmetic(Sink &, T const& src, ojstream & erased,
+                             std::false_type)
+{
+  erased << src;
+}
+
+template<class Sink, class T>
+void static_write_value(Sink & s, T const& src, ojstream & erased,
+                        std::false_type)
+{
+  typedef typename std::conditional<
+      std::is_floating_point<T>::value, double, int64_t>::type wide;
+  bool const direct = std::is_arithmetic<T>::value
+                      && !std::is_same<T, char>::value;
+  static_write_arithmetic<wide>(s, src, erased,
+                                std::integral_constant<bool, direct>());
+}
+
+template<class Sink, class T>
+void static_write(Sink & s, T const& src, ojstream & erased);
+
+//! Writes members of an expressible type with static_write, like
+//! jobject_writer
+
+template<class Sink, class T>
+class static_object_writer
+{
+public:
+  static_object_writer(std::shared_ptr<Sink> const& p_sink, T const& src)
+    : sink_(*p_sink)
+    , erased_(p_sink)
+    , src_(src)
+  {}
+
+  template<class MemberT, class BaseT,
+           class = EnabledIfIsBaseOf<BaseT, T>>
+  static_object_writer & member(std::string const& key,
+                                MemberT BaseT::*mptr)
+  {
+    BaseT const& base = src_;
+    sink_.set_key(key.data(), key.size());
+    static_write(sink_, base.*mptr, erased_);
+    return *this;
+  }
+
+private:
+  Sink & sink_;
+  ojstream erased_;
+  T const& src_;
+};
+
+template<class Sink, class T>
+void static_write_value(Sink & s, T const& src, ojstream &, std::true_type)
+{
+  std::shared_ptr<Sink> p_sub = s.begin_object(true);
+  static_object_writer<Sink, T> writer(p_sub, src);
+  T::jios_express(writer);
+  p_sub->terminate();
+}
+
+//! Sparse expressible types omit default members, so are written
+//! through jios_write
+template<typename T>
+struct is_static_object_written
+  : std::integral_constant<
+        bool,
+        is_jobject_expressed<T>::value
+        && !std::is_base_of<jobject_sparse_expressible<T>, T>::value>
+{};
+
+template<class Sink, class T>
+void static_write(Sink & s, T const& src, ojstream & erased)
+{
+  static_write_value(s, src, erased, is_static_object_written<T>());
+}
+
+} // namespace detail
+
+//! Stream of values read from a Source without virtual dispatch
+
+template<class Source>
+class basic_ijstream
+  : boost::noncopyable
+{
+public:
+  typedef typename Source::value_type value_type;
+
+  explicit basic_ijstream(std::shared_ptr<Source> const& p_src)
+    : p_src_(p_src)
+    , expired_(false)
+  {}
+
+  basic_ijstream(basic_ijstream && rhs)
+    : p_src_(std::move(rhs.p_src_))
+    , expired_(rhs.expired_)
+  {}
+
+  bool fail() const { return p_src_->fail(); }
+
+  bool at_end()
+  {
+    unexpire();
+    return p_src_->at_terminator();
+  }
+
+  value_type & get()
+  {
+    unexpire();
+    BOOST_ASSERT(!p_src_->at_terminator());
+    expired_ = true;
+    return p_src_->value();
+  }
+
+  //! Key of the next value when reading an object
+  std::string key()
+  {
+    unexpire();
+    return p_src_->value().key();
+  }
+
+  template<typename T>
+  basic_ijstream & operator >> (T & dest)
+  {
+    detail::static_read(this->get(), dest);
+    return *this;
+  }
+
+  //! Read the next value as an array, returning a stream of its elements
+  basic_ijstream array() { return basic_ijstream(get().sub_source(false)); }
+
+  //! Read the next value as an object, returning a stream of its members
+  basic_ijstream object() { return basic_ijstream(get().sub_source(true)); }
+
+  //! Type-erased stream continuing from the current position.
+  //! This stream should not be used while the returned one is in use.
+  ijstream erased()
+  {
+    unexpire();
+    return ijstream(p_src_);
+  }
+
+private:
+  void unexpire()
+  {
+    if (expired_) {
+      p_src_->next();
+      expired_ = false;
+    }
+  }
+
+  std::shared_ptr<Source> p_src_;
+  bool expired_;
+};
+
+//! Stream of values written to a Sink without virtual dispatch
+
+template<class Sink>
+class basic_ojstream
+  : boost::noncopyable
+{
+public:
+  explicit basic_ojstream(std::shared_ptr<Sink> const& p_sink)
+    : p_sink_(p_sink)
+    , erased_(p_sink)
+  {}
+
+  basic_ojstream(basic_ojstream && rhs)
+    : p_sink_(std::move(rhs.p_sink_))
+    , erased_(std::move(rhs.erased_))
+  {}
+
+  template<typename T>
+  basic_ojstream & operator << (T const& src)
+  {
+    detail::static_write(*p_sink_, src, erased_);
+    return *this;
+  }
+
+  //! Write key of the next value when writing an object
+  basic_ojstream & key(std::string const& k)
+  {
+    p_sink_->set_key(k.data(), k.size());
+    return *this;
+  }
+
+  //! Begin an array as the next value, returning a stream of its elements
+  basic_ojstream array(bool multimode = false)
+  {
+    return basic_ojstream(p_sink_->begin_array(multimode));
+  }
+
+  //! Begin an object as the next value, returning a stream of its members
+  basic_ojstream object(bool multimode = false)
+  {
+    return basic_ojstream(p_sink_->begin_object(multimode));
+  }
+
+  void terminate() { p_sink_->terminate(); }
+
+  //! Type-erased stream writing to the same sink
+  ojstream & erased() { return erased_; }
+
+private:
+  std::shared_ptr<Sink> p_sink_;
+  ojstream erased_;
+};
+
+
+} // namespace
+
+#endif
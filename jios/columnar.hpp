@@ -0,0 +1,167 @@
+#ifndef JIOS_COLUMNAR_HPP
+#define JIOS_COLUMNAR_HPP
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <jios/jin.hpp>
+#include <jios/jout.hpp>
+
+namespace jios {
+
+
+class column_table;
+
+//! Values found at one path of a stream of records, one row per record
+//! or, below arrays, per array element. Rows are null where a value is
+//! null or missing. Buffers of all types have an entry for every row.
+
+class column
+{
+public:
+  //! jnull until a non-null value is written. Integer columns become
+  //! jfloat when a float is written. Objects have no column of their
+  //! own, their members being columns at "path.key".
+  json_type type() const { return type_; }
+
+  std::size_t size() const { return size_; }
+
+  //! Bitmap of rows with values, least significant bit first
+  std::vector<std::uint8_t> const& validity() const { return validity_; }
+
+  bool valid(std::size_t row) const
+  {
+    return validity_[row / 8] & (1 << (row % 8));
+  }
+
+  //! Values of jinteger columns, and of jbool columns as 0 or 1
+  std::vector<int64_t> const& integers() const { return integers_; }
+
+  //! Values of jfloat columns
+  std::vector<double> const& reals() const { return reals_; }
+
+  //! Whether strings are stored as codes into a dictionary of distinct
+  //! values. Columns switch to plain strings when the dictionary grows
+  //! past column_table::max_dictionary_size.
+  bool dictionary_encoded() const { return dictionary_encoded_; }
+
+  //! Dictionary index of each row of dictionary encoded strings
+  std::vector<std::uint32_t> const& codes() const { return codes_; }
+
+  //! For strings, bytes_[offsets_[i], offsets_[i + 1]) is dictionary
+  //! entry i, or row i of plain strings. For jarray columns, elements of
+  //! row i are rows [offsets_[i], offsets_[i + 1]) of "path[]" columns.
+  std::vector<std::uint64_t> const& offsets() const { return offsets_; }
+
+  std::string const& bytes() const { return bytes_; }
+
+  //! String of a row of a jstring column
+  boost::string_ref string_at(std::size_t row) const;
+
+private:
+  friend class column_table;
+  friend class columnar_ojnode;
+
+  column(std::size_t domain, std::size_t max_dictionary_size);
+
+  //! Append null rows up to row
+  void pad_to(std::size_t row);
+
+  //! Start appending a value of type t at row. False on type conflict
+  //! or if row already has a value.
+  bool begin_row(std::size_t row, json_type t);
+
+  void push_placeholder();
+  void push_valid();
+  void push(int64_t value);
+  void push(double value);
+  void push(bool value);
+  void push(std::string const& value);
+  void push_list_end(std::uint64_t end);
+
+  void set_type(json_type t);
+  void append_entry(boost::string_ref s);
+  void make_plain();
+
+  std::size_t const domain_;
+  std::size_t const max_dictionary_size_;
+  std::size_t child_domain_;
+  json_type type_;
+  std::size_t size_;
+  std::vector<std::uint8_t> validity_;
+  std::vector<int64_t> integers_;
+  std::vector<double> reals_;
+  bool dictionary_encoded_;
+  std::vector<std::uint32_t> codes_;
+  std::vector<std::uint64_t> offsets_;
+  std::string bytes_;
+  std::unordered_map<std::string, std::uint32_t> lookup_;
+};
+
+//! Columns of records keyed by JSON path. Record members are at paths
+//! like "name" and "address.city", array elements at paths like "tags[]"
+//! and "items[].price". Top-level non-objects are at path "".
+
+class column_table
+  : boost::noncopyable
+{
+public:
+  static std::size_t const default_max_dictionary_size = 1 << 16;
+
+  explicit column_table(std::size_t max_dictionary_size
+                            = default_max_dictionary_size);
+
+  //! Number of records
+  std::size_t size() const { return domains_[0].rows; }
+
+  //! Whether a write conflicted with the type of a column or wrote a
+  //! member twice. Writes are ignored after a failure.
+  bool fail() const { return failed_; }
+
+  std::map<std::string, column> const& columns() const { return columns_; }
+
+  //! Column at path or nullptr if none
+  column const* find(std::string const& path) const;
+
+  void clear();
+
+private:
+  friend class columnar_ojnode;
+
+  //! Rows sharing a row count: records, or elements of one array path
+  struct domain
+  {
+    std::size_t rows;
+    std::vector<column *> columns;
+  };
+
+  column * at(std::string const& path, std::size_t domain);
+  std::size_t new_domain();
+
+  //! Complete the current row of domain d, padding its columns
+  void end_row(std::size_t d);
+
+  std::size_t const max_dictionary_size_;
+  std::map<std::string, column> columns_;
+  std::vector<domain> domains_;
+  bool failed_;
+};
+
+//! ojstream appending each value written to it as a record of dest
+ojstream columnar_out(column_table & dest);
+
+//! Append up to max_count records read from src to dest, returning the
+//! number of records appended
+std::size_t read_columns(ijstream & src, column_table & dest,
+                         std::size_t max_count
+                             = std::numeric_limits<std::size_t>::max());
+
+
+} // namespace
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef JIOS_COMPRESS_HPP
+#define JIOS_COMPRESS_HPP
+
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <jios/jin.hpp>
+#include <jios/jout.hpp>
+
+namespace jios {
+
+
+enum class compression {
+  gzip,
+  zstd  //! only available if built with zstd
+};
+
+bool compression_supported(compression c);
+
+//! istream decompressing gzip or zstd input, detected by magic bytes.
+//! Input that is not compressed is returned as is.
+//! Decompressed data is written directly into the reader's buffer.
+std::shared_ptr<std::istream> decompressed_istream(std::istream & is);
+std::shared_ptr<std::istream>
+    decompressed_istream(std::shared_ptr<std::istream> const& p_is);
+
+//! ostream compressing into os. With threads > 1, gzip output is
+//! compressed in independent blocks (concatenated gzip members) by a pool
+//! of worker threads and zstd uses its own worker threads.
+//! Output is complete once finish_compressed is called, or else once
+//! the returned ostream is destroyed. Write errors set badbit on the
+//! returned ostream; failures to complete the output also set badbit
+//! on os.
+std::shared_ptr<std::ostream>
+    compressed_ostream(std::ostream & os,
+                       compression c = compression::gzip,
+                       unsigned threads = 1);
+
+//! Complete the output of an ostream returned by compressed_ostream and
+//! flush it into its target. Sets badbit on both streams if compressing
+//! or writing failed. Throws std::invalid_argument for other streams.
+void finish_compressed(std::ostream & os);
+
+ijstream compressed_json_in(std::istream & is);
+ijstream compressed_json_in(std::shared_ptr<std::istream> const& p_is);
+
+//! Output is complete once the returned ojstream is destroyed.
+//! Failures then set badbit on os.
+ojstream compressed_lined_json_out(std::ostream & os,
+                                   compression c = compression::gzip,
+                                   unsigned threads = 1);
+
+
+} // namespace
+
+#endif
+
@@ -28,6 +28,55 @@ struct jobject_expressible
   }
 };
 
+template<class T>
+struct jobject_compiled_expresser
+{
+  static void write(ojvalue & oj, T const& src);
+  static void read(ijvalue & ij, T & dest);
+};
+
+//! Same as jobject_expressible, except JSON object keys are compiled once
+//! per type into a lookup table used to read members.
+
+template<class Derived>
+struct jobject_compiled_expressible
+{
+  friend void jios_write(ojvalue & oj, Derived const& src)
+  {
+    jobject_compiled_expresser<Derived>::write(oj, src);
+  }
+
+  friend void jios_read(ijvalue & ij, Derived & dest)
+  {
+    jobject_compiled_expresser<Derived>::read(ij, dest);
+  }
+};
+
+
+template<class T>
+struct jobject_sparse_expresser
+{
+  static void write(ojvalue & oj, T const& src);
+  static void read(ijvalue & ij, T & dest);
+};
+
+//! Same as jobject_expressible, except members equal to their default
+//! (empty optionals and containers, zero numbers, empty strings) are
+//! omitted when writing, like unset protobuf fields.
+
+template<class Derived>
+struct jobject_sparse_expressible
+{
+  friend void jios_write(ojvalue & oj, Derived const& src)
+  {
+    jobject_sparse_expresser<Derived>::write(oj, src);
+  }
+
+  friend void jios_read(ijvalue & ij, Derived & dest)
+  {
+    jobject_sparse_expresser<Derived>::read(ij, dest);
+  }
+};
 
 } // namespace jios
 
@@ -5,7 +5,14 @@
 #include "jin.hpp"
 #include "jout.hpp"
 
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace jios {
 
@@ -45,6 +52,20 @@ struct is_jobject_expressible<T, typename detail::jobject_jios_express<T>::tag>
   : std::true_type
 {};
 
+//! Whether T reads and writes as a JSON object of its jios_express
+//! members, by deriving from jobject_expressible or one of its variants.
+//! Types with jios_express reading and writing otherwise, such as with
+//! jtuple_reader and jtuple_writer, are not.
+
+template<typename T>
+struct is_jobject_expressed
+  : std::integral_constant<
+        bool,
+        std::is_base_of<jobject_expressible<T>, T>::value
+        || std::is_base_of<jobject_compiled_expressible<T>, T>::value
+        || std::is_base_of<jobject_sparse_expressible<T>, T>::value>
+{};
+
 //! JSON object expressing classes
 
 template<class T, typename Omitted = std::true_type>
@@ -159,6 +180,467 @@ private:
   bool key_found_;
 };
 
+//! Reader looking up members by key in a table built once per type.
+//! Keys are compared in place by length, first byte and then in full,
+//! starting after the previous match since members usually come in
+//! order. Each entry reads through its member pointer with a plain
+//! function pointer.
+
+template<class T, class Expresser = T>
+class jobject_compiled_reader
+{
+public:
+  static
+  void read(ijvalue & ij, T & dest)
+  {
+    jobject_clearer<Expresser>::clear(dest);
+    merge(ij, dest);
+  }
+
+  static
+  void merge(ijvalue & ij, T & dest)
+  {
+    static jobject_compiled_reader const schema;
+    ijobject ijo = ij.object();
+    std::size_t next = 0;
+    while (!ijo.fail() && !ijo.at_end()) {
+      ijpair & kv = ijo.get();
+      std::size_t i = schema.find(kv.key_ref(), next);
+      if (i == schema.members_.size()) {
+        ijo.set_failbit();
+      } else {
+        member_entry const& m = schema.members_[i];
+        m.read(kv, dest, &m.mptr);
+        next = i + 1;
+      }
+    }
+  }
+
+  template<class MemberT, class BaseT,
+           class = detail::EnabledIfIsBaseOf<BaseT, T>>
+  jobject_compiled_reader & member(std::string const& key,
+                                   MemberT BaseT::*mptr)
+  {
+    static_assert(sizeof(mptr) == sizeof(member_storage),
+                  "unexpected size of member pointer");
+    members_.emplace_back();
+    members_.back().key = key;
+    members_.back().read = &read_member<MemberT, BaseT>;
+    std::memcpy(&members_.back().mptr, &mptr, sizeof(mptr));
+    return *this;
+  }
+
+private:
+  typedef typename std::aligned_storage<
+      sizeof(char T::*), alignof(char T::*)>::type member_storage;
+
+  struct member_entry
+  {
+    std::string key;
+    void (*read)(ijvalue &, T &, member_storage const*);
+    member_storage mptr;
+  };
+
+  jobject_compiled_reader() { Expresser::jios_express(*this); }
+
+  template<class MemberT, class BaseT>
+  static
+  void read_member(ijvalue & ij, T & dest, member_storage const* p)
+  {
+    MemberT BaseT::*mptr;
+    std::memcpy(&mptr, p, sizeof(mptr));
+    BaseT & base = dest;
+    ij.read(base.*mptr);
+  }
+
+  //! Index of the member named key, searching from hint, or the
+  //! number of members if none
+  std::size_t find(boost::string_ref key, std::size_t hint) const
+  {
+    std::size_t const n = members_.size();
+    for (std::size_t k = 0; k < n; ++k) {
+      std::size_t i = (hint + k < n ? hint + k : hint + k - n);
+      std::string const& name = members_[i].key;
+      if (name.size() == key.size()
+          && (key.empty() || name[0] == key[0])
+          && std::memcmp(name.data(), key.data(), key.size()) == 0) {
+        return i;
+      }
+    }
+    return n;
+  }
+
+  std::vector<member_entry> members_;
+};
+
+////////////////////////////////////////////////////////////////////
+// jios_update: reading into existing values reusing their storage
+
+template<class T, typename Omitted = std::true_type>
+struct jios_updater;
+
+//! Read into dest, reusing its storage. Strings, elements of vectors,
+//! nodes of std::map and members of jobject expressible types keep
+//! their heap capacity across reads of similarly shaped values, such as
+//! when reading a stream of records into the same object.
+template<class T>
+bool jios_update(ijvalue & ij, T & dest)
+{
+  jios_updater<T>::update(ij, dest);
+  return !ij.fail();
+}
+
+//! Resets a value to empty, keeping heap capacity where possible
+
+template<class T, typename Omitted = std::true_type>
+struct jios_resetter
+{
+  static void reset(T & dest) { dest = T(); }
+};
+
+template<class CharT, class Traits, class Alloc>
+struct jios_resetter<std::basic_string<CharT, Traits, Alloc>>
+{
+  static
+  void reset(std::basic_string<CharT, Traits, Alloc> & dest) { dest.clear(); }
+};
+
+template<class T, class Alloc>
+struct jios_resetter<std::vector<T, Alloc>>
+{
+  static void reset(std::vector<T, Alloc> & dest) { dest.clear(); }
+};
+
+template<class T>
+struct jios_resetter<T, typename is_jobject_expressed<T>::type>
+{
+  static
+  void reset(T & dest)
+  {
+    jios_resetter resetter(dest);
+    T::jios_express(resetter);
+  }
+
+  template<class MemberT, class BaseT,
+           class = detail::EnabledIfIsBaseOf<BaseT, T>>
+  jios_resetter & member(std::string const&, MemberT BaseT::*mptr)
+  {
+    BaseT & base = dest_;
+    jios_resetter<MemberT>::reset(base.*mptr);
+    return *this;
+  }
+
+private:
+  jios_resetter(T & dest) : dest_(dest) {}
+
+  T & dest_;
+};
+
+//! Default update is a plain read, which reuses capacity of strings and
+//! numeric vectors
+
+template<class T, typename Omitted>
+struct jios_updater
+{
+  static void update(ijvalue & ij, T & dest) { ij.read(dest); }
+};
+
+template<class T>
+struct jios_updater<boost::optional<T>>
+{
+  static
+  void update(ijvalue & ij, boost::optional<T> & dest)
+  {
+    if (ij.type() == json_type::jnull) {
+      dest = boost::none;
+    } else {
+      if (!dest) { dest.emplace(); }
+      jios_update(ij, *dest);
+    }
+  }
+};
+
+//! Elements update existing elements in order
+template<class T, class Alloc>
+struct jios_updater<std::vector<T, Alloc>,
+                    typename std::integral_constant<
+                        bool, !std::is_arithmetic<T>::value>::type>
+{
+  static
+  void update(ijvalue & ij, std::vector<T, Alloc> & dest)
+  {
+    ijarray ija = ij.array();
+    std::size_t count = 0;
+    while (!ija.at_end()) {
+      if (count == dest.size()) { dest.emplace_back(); }
+      jios_update(ija.get(), dest[count]);
+      ++count;
+    }
+    dest.resize(count);
+  }
+};
+
+//! Members update existing entries with equal keys. Entries are erased
+//! or inserted as needed, with no extra lookups for keys in order.
+template<class Key, class T, class Compare, class Alloc>
+struct jios_updater<std::map<Key, T, Compare, Alloc>>
+{
+  typedef std::map<Key, T, Compare, Alloc> map_type;
+
+  static
+  void update(ijvalue & ij, map_type & dest)
+  {
+    ijobject ijo = ij.object();
+    // entries before cursor have been read
+    auto cursor = dest.begin();
+    Key key;
+    while (!ijo.fail() && !ijo.at_end()) {
+      ijpair & kv = ijo.get();
+      if (!kv.parse_key(key)) {
+        ijo.set_failbit();
+        break;
+      }
+      auto it = dest.lower_bound(key);
+      if (cursor != dest.end() && !dest.key_comp()(key, cursor->first)) {
+        cursor = dest.erase(cursor, it);
+      }
+      if (it == dest.end() || dest.key_comp()(key, it->first)) {
+        it = dest.emplace_hint(it, key, T());
+      }
+      jios_update(kv, it->second);
+      if (it == cursor) { ++cursor; }
+    }
+    dest.erase(cursor, dest.end());
+  }
+};
+
+//! Members present update in place. Members missing are reset.
+//! Unknown keys set failbit, as with jobject_reader.
+template<class T>
+struct jios_updater<T, typename is_jobject_expressed<T>::type>
+{
+  static
+  void update(ijvalue & ij, T & dest)
+  {
+    jios_updater updater(dest);
+    // members past the seen bitmask are reset before reading
+    updater.mode_ = mode::reset_unmasked;
+    T::jios_express(updater);
+    ijobject ijo = ij.object();
+    updater.mode_ = mode::read;
+    while (!ijo.fail() && !ijo.at_end()) {
+      ijpair & kv = ijo.get();
+      updater.p_kv_ = &kv;
+      updater.key_ = kv.key_ref();
+      updater.found_ = false;
+      updater.index_ = 0;
+      T::jios_express(updater);
+      if (!updater.found_) {
+        ijo.set_failbit();
+      }
+    }
+    updater.mode_ = mode::reset_unseen;
+    updater.index_ = 0;
+    T::jios_express(updater);
+  }
+
+  template<class MemberT, class BaseT,
+           class = detail::EnabledIfIsBaseOf<BaseT, T>>
+  jios_updater & member(std::string const& key, MemberT BaseT::*mptr)
+  {
+    BaseT & base = dest_;
+    MemberT & data = base.*mptr;
+    bool const masked = index_ < 64;
+    std::uint64_t const bit = (masked ? std::uint64_t(1) << index_ : 0);
+    switch (mode_) {
+      case mode::reset_unmasked:
+        if (!masked) { jios_resetter<MemberT>::reset(data); }
+        break;
+      case mode::read:
+        if (!found_ && key_ == key) {
+          found_ = true;
+          seen_ |= bit;
+          jios_update(*p_kv_, data);
+        }
+        break;
+      case mode::reset_unseen:
+        if (masked && !(seen_ & bit)) { jios_resetter<MemberT>::reset(data); }
+        break;
+    }
+    ++index_;
+    return *this;
+  }
+
+private:
+  enum class mode { reset_unmasked, read, reset_unseen };
+
+  jios_updater(T & dest)
+    : dest_(dest)
+    , mode_(mode::read)
+    , p_kv_(nullptr)
+    , found_(false)
+    , index_(0)
+    , seen_(0)
+  {}
+
+  T & dest_;
+  mode mode_;
+  ijpair * p_kv_;
+  boost::string_ref key_;
+  bool found_;
+  std::size_t index_;
+  std::uint64_t seen_;
+};
+
+////////////////////////////////////////////////////////////////////
+// sparse writing omitting default valued members
+
+namespace detail {
+
+template<class T>
+auto has_empty(int) -> decltype(std::declval<T const&>().empty(),
+                                std::true_type());
+
+template<class T>
+std::false_type has_empty(...);
+
+template<bool B>
+using enable_if_t = typename std::enable_if<B, std::true_type>::type;
+
+} // namespace detail
+
+//! Whether a value equals its default and is omitted by sparse writers.
+//! Values of other types are never omitted.
+
+template<class T, typename Omitted = std::true_type>
+struct jios_default_test
+{
+  static bool is_default(T const&) { return false; }
+};
+
+template<class T>
+struct jios_default_test<T, detail::enable_if_t<std::is_arithmetic<T>::value>>
+{
+  static bool is_default(T const& src) { return src == T(); }
+};
+
+//! Strings and containers
+template<class T>
+struct jios_default_test<T, detail::enable_if_t<
+    decltype(detail::has_empty<T>(0))::value
+    && !is_jobject_expressed<T>::value>>
+{
+  static bool is_default(T const& src) { return src.empty(); }
+};
+
+template<class T>
+struct jios_default_test<boost::optional<T>>
+{
+  static bool is_default(boost::optional<T> const& src) { return !src; }
+};
+
+//! Expressible types with all members default
+template<class T>
+struct jios_default_test<T, typename is_jobject_expressed<T>::type>
+{
+  static
+  bool is_default(T const& src)
+  {
+    jios_default_test test(src);
+    T::jios_express(test);
+    return test.all_default_;
+  }
+
+  template<class MemberT, class BaseT,
+           class = detail::EnabledIfIsBaseOf<BaseT, T>>
+  jios_default_test & member(std::string const&, MemberT BaseT::*mptr)
+  {
+    BaseT const& base = src_;
+    if (all_default_) {
+      all_default_ = jios_default_test<MemberT>::is_default(base.*mptr);
+    }
+    return *this;
+  }
+
+private:
+  jios_default_test(T const& src) : src_(src), all_default_(true) {}
+
+  T const& src_;
+  bool all_default_;
+};
+
+//! Writer omitting members equal to their default, including in
+//! expressible members
+
+template<class T, class Expresser = T>
+struct jobject_sparse_writer
+{
+  static
+  void write(ojvalue & oj, T const& src)
+  {
+    jobject_sparse_writer writer(oj.object(true), src);
+    Expresser::jios_express(writer);
+    writer.ojo_ << endj;
+  }
+
+  template<class MemberT, class BaseT,
+           class = detail::EnabledIfIsBaseOf<BaseT, T>>
+  jobject_sparse_writer & member(std::string const& key,
+                                 MemberT BaseT::*mptr)
+  {
+    BaseT const& base = src_;
+    MemberT const& data = base.*mptr;
+    if (!jios_default_test<MemberT>::is_default(data)) {
+      write_member(key, data, is_jobject_expressed<MemberT>());
+    }
+    return *this;
+  }
+
+private:
+  jobject_sparse_writer(ojobject && dest, T const& src)
+    : ojo_(std::move(dest))
+    , src_(src)
+  {}
+
+  template<class MemberT>
+  void write_member(std::string const& key, MemberT const& data,
+                    std::true_type)
+  {
+    jobject_sparse_writer<MemberT>::write(ojo_.put(key), data);
+  }
+
+  template<class MemberT>
+  void write_member(std::string const& key, MemberT const& data,
+                    std::false_type)
+  {
+    ojo_ << std::tie(key, data);
+  }
+
+  ojobject ojo_;
+  T const& src_;
+};
+
+//! Reference to an expressible value to write sparsely, as by
+//! jios_write(oj, sparse(value))
+
+template<class T>
+struct sparse_ref
+{
+  static_assert(is_jobject_expressible<T>::value,
+                "sparse writing requires a jobject expressible type");
+
+  T const& value;
+};
+
+template<class T>
+sparse_ref<T> sparse(T const& src) { return sparse_ref<T>{src}; }
+
+template<class T>
+void jios_write(ojvalue & oj, sparse_ref<T> const& src)
+{
+  jobject_sparse_writer<T>::write(oj, src.value);
+}
+
 // jobject_expresser implementation
 
 template<class T>
@@ -173,6 +655,34 @@ void jobject_expresser<T>::read(ijvalue & ij, T & dest)
   jobject_reader<T>::read(ij, dest);
 }
 
+// jobject_compiled_expresser implementation
+
+template<class T>
+void jobject_compiled_expresser<T>::write(ojvalue & oj, T const& src)
+{
+  jobject_writer<T>::write(oj, src);
+}
+
+template<class T>
+void jobject_compiled_expresser<T>::read(ijvalue & ij, T & dest)
+{
+  jobject_compiled_reader<T>::read(ij, dest);
+}
+
+// jobject_sparse_expresser implementation
+
+template<class T>
+void jobject_sparse_expresser<T>::write(ojvalue & oj, T const& src)
+{
+  jobject_sparse_writer<T>::write(oj, src);
+}
+
+template<class T>
+void jobject_sparse_expresser<T>::read(ijvalue & ij, T & dest)
+{
+  jobject_reader<T>::read(ij, dest);
+}
+
 //! JSON tuple (array) expressing classes
 
 template<class T, class Expresser = T>
@@ -209,13 +719,15 @@ template<class T, class Expresser = T>
 class jtuple_reader
 {
 public:
+  //! Fails unless the array has exactly one element per member
   static
   void read(ijvalue & ij, T & dest)
   {
     dest = T();
     jtuple_reader reader(ij.array(), dest);
-    while (!reader.fail() && !reader.at_end()) {
-      Expresser::jios_express(reader);
+    Expresser::jios_express(reader);
+    if (!ij.fail() && !reader.ijo_.at_end()) {
+      ij.set_failbit();
     }
   }
 
@@ -223,7 +735,11 @@ public:
   jtuple_reader & member(MemberT Base::*mptr)
   {
     MemberT & data = dest_.*mptr;
-    ijo_ >> data;
+    if (ijo_.at_end()) {
+      if (!ijo_.fail()) { ijo_.set_failbit(); }
+    } else {
+      ijo_ >> data;
+    }
     return *this;
   }
 
@@ -233,10 +749,6 @@ private:
     , dest_(dest)
   {}
 
-  bool at_end() { return ijo_.at_end(); }
-
-  bool fail() const { return ijo_.fail(); }
-
   ijarray ijo_;
   T & dest_;
 };
@@ -0,0 +1,49 @@
+#ifndef JIOS_EXTRACT_HPP
+#define JIOS_EXTRACT_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <jios/jin.hpp>
+
+namespace jios {
+
+
+//! Extracts values at a set of JSON Pointer (RFC 6901) paths in one pass.
+//! A path component of "*" matches any object member or array element.
+//! Values not on any bound path are skipped without being read.
+//! Paths matching by exact component and by "*" are all followed, and
+//! values at bound paths are searched for longer bound paths too. A
+//! value read by more than one of these is first recorded on a tape.
+
+class path_extractor
+{
+public:
+  typedef std::function<void(ijvalue &)> callback;
+
+  path_extractor();
+
+  //! Call f with each value found at pointer
+  path_extractor & bind(std::string const& pointer, callback const& f);
+
+  //! Read each value found at pointer into dest
+  template<class T, class = typename std::enable_if<
+                        !std::is_convertible<T &, callback>::value>::type>
+  path_extractor & bind(std::string const& pointer, T & dest)
+  {
+    return bind(pointer, callback([&dest](ijvalue & ij) { ij.read(dest); }));
+  }
+
+  void extract(ijvalue & src) const;
+
+  struct node;
+
+private:
+  std::shared_ptr<node> root_;
+};
+
+
+} // namespace
+
+#endif
+
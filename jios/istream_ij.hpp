@@ -57,6 +57,51 @@ private:
   }
 };
 
+//! Quote and escape aware scanner finding the end of a single JSON value
+//! without parsing or allocating.
+
+class value_scanner
+{
+public:
+  value_scanner() { reset(); }
+
+  void reset() { state_ = scan_state::start; depth_ = 0; }
+
+  //! Scan characters starting at it, stopping just past the end of
+  //! the value. Return pointer past the last character consumed.
+  const char * scan(const char * it, const char * end);
+
+  //! Signal there is no more input. Completes a pending bare literal.
+  void finish();
+
+  bool done() const { return state_ == scan_state::done; }
+  bool failed() const { return state_ == scan_state::error; }
+
+private:
+  enum class scan_state {
+    start,
+    literal,
+    string,
+    string_escape,
+    nested,
+    nested_string,
+    nested_escape,
+    done,
+    error
+  };
+
+  scan_state state_;
+  std::size_t depth_;
+};
+
+//! Pointer past the JSON number grammar match at the start of
+//! [it, end), or null if there is none.
+const char * scan_json_number(const char * it, const char * end);
+
+//! Consume one JSON value from input without parsing it.
+//! Blocks until the end of the value is available.
+void skip_value(istream_facade & is);
+
 //! streaming JSON parser from istream source 
 
 
@@ -90,6 +135,17 @@ std::shared_ptr<istream_parser>
     make_streaming_parser(std::shared_ptr<istream_facade> const&,
                           istream_parser_factory const&);
 
+//! Parser streaming top-level arrays and parsing other values with
+//! json-c, as used by json_in
+std::shared_ptr<istream_parser>
+    make_split_parser(std::shared_ptr<istream_facade> const&);
+
+//! Source of the remaining elements of an array, with input positioned
+//! at an element (past '[' or ',') or at the closing ']'
+std::shared_ptr<ijsource>
+    make_array_tail_ijsource(std::shared_ptr<istream_facade> const&,
+                             std::shared_ptr<istream_parser> const&);
+
 
 } // namespace jios
 
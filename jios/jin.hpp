@@ -1,6 +1,7 @@
 #ifndef JIOS_JIN_HPP
 #define JIOS_JIN_HPP
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <vector>
@@ -9,10 +10,14 @@
 #include <forward_list>
 #include <array>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <tuple>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <boost/iterator/iterator_adaptor.hpp>
+#include <boost/utility/string_ref.hpp>
 #include "jout.hpp"
 
 namespace jios {
@@ -32,6 +37,7 @@ void jios_read(ijvalue & ij, uint32_t & dest);
 void jios_read(ijvalue & ij, uint64_t & dest);
 void jios_read(ijvalue & ij, float & dest);
 void jios_read(ijvalue & src, ojvalue & dest);
+void jios_read(ijvalue & ij, number_text & dest);
 
 //! Stream of JSON-ish values (base for ijarray and ijobject)
 
@@ -54,6 +60,15 @@ public:
 
   bool hint_multiline() const;
 
+  //! Number of values remaining if cheaply known by the back-end, else 0
+  std::size_t size_hint();
+
+  //! Discard the next value without reading it.
+  //! Only elements of arrays streamed by json_in are scanned past without
+  //! parsing; objects and other values are parsed whole before any member
+  //! is skipped.
+  void skip();
+
   bool operator ! () const { return this->fail(); }
 
   explicit operator bool() const { return !(this->fail()); }
@@ -61,6 +76,7 @@ public:
 protected:
   ijpair & dereference();
   ijpair & extract();
+  ijsource & source();
 
   template<class Reference>
   class basic_iterator
@@ -121,6 +137,13 @@ public:
   ijarray() {}
 
   ijarray(std::shared_ptr<ijsource> const& pimpl) : ijstream(pimpl) {}
+
+  //! Read up to n consecutive numeric elements into dest.
+  //! Return the count read, less than n only at end of array or failure.
+  std::size_t read_numbers(int64_t * dest, std::size_t n);
+  std::size_t read_numbers(int32_t * dest, std::size_t n);
+  std::size_t read_numbers(double * dest, std::size_t n);
+  std::size_t read_numbers(float * dest, std::size_t n);
 };
 
 //! JSON-ish ijobject 
@@ -242,6 +265,25 @@ public:
   ijarray array();
   ijobject object();
 
+  //! Discard this value. An array streamed by json_in scans past its
+  //! remaining input without parsing it; other values, including objects
+  //! and their members, are already parsed whole.
+  void skip() { do_skip(); }
+
+  //! Point to the compact JSON text of this value without decoding it,
+  //! if the back-end holds one. The text stays valid until the source
+  //! advances. Returns false, leaving the value unread, otherwise.
+  bool raw_json(char const* & p, std::size_t & len)
+  {
+    return do_raw_json(p, len);
+  }
+
+  //! Text of this number value without converting it, as in the input
+  //! if the back-end keeps the text, else formatted from the stored value.
+  //! Sets failbit if not a number. The text stays valid until the source
+  //! advances.
+  boost::string_ref raw_number() { return do_raw_number(); }
+
   json_type type() const;
   bool is_array() const { return json_type::jarray == this->type(); }
   bool is_object() const { return json_type::jobject == this->type(); }
@@ -251,6 +293,9 @@ protected:
 
   typedef std::ostreambuf_iterator<char> buffer_iterator;
 
+  //! Default formats the parsed value
+  virtual boost::string_ref do_raw_number();
+
 private:
   friend class ijstreamoid;
   friend class ijpair;
@@ -274,9 +319,13 @@ private:
   virtual ijarray do_begin_array() = 0;
   virtual ijobject do_begin_object() = 0;
 
+  virtual void do_skip() {}
+  virtual bool do_raw_json(char const* &, std::size_t &) { return false; }
+
   std::istream & read_string_value();
   bool good_string_value_read();
   mutable std::stringstream buf_;
+  std::string number_buf_;
 };
 
 class ijpair : public ijvalue
@@ -284,6 +333,10 @@ class ijpair : public ijvalue
 public:
   std::string key() const;
 
+  //! Key without copying it where the back-end holds its text.
+  //! Valid until the source advances.
+  boost::string_ref key_ref() const { return do_key_ref(); }
+
   bool parse_key(std::string & dest) const;
 
   template<class T>
@@ -298,6 +351,9 @@ private:
   std::istream & read_key_value() const;
 
   virtual std::string do_key() const = 0;
+  virtual boost::string_ref do_key_ref() const;
+
+  mutable std::string key_buf_;
 };
 
 class ijsource
@@ -309,7 +365,10 @@ class ijsource
   virtual bool do_is_terminator() = 0;
   virtual void do_advance() = 0;
   virtual bool do_hint_multiline() const { return false; }
+  virtual std::size_t do_size_hint() const { return 0; }
   virtual bool do_expecting() = 0;
+  virtual std::size_t do_read_numbers(int64_t * dest, std::size_t n);
+  virtual std::size_t do_read_numbers(double * dest, std::size_t n);
 
 public:
   virtual ~ijsource() {}
@@ -324,10 +383,30 @@ public:
 
   bool hint_multiline() { return do_hint_multiline(); }
 
+  //! Number of values remaining including the current one, 0 if unknown
+  std::size_t size_hint() const { return do_size_hint(); }
+
+  //! Read up to n numbers into dest, advancing past each.
+  //! Stop at terminator or failure. Return the count read.
+  std::size_t read_numbers(int64_t * dest, std::size_t n)
+  {
+    return do_read_numbers(dest, n);
+  }
+  std::size_t read_numbers(double * dest, std::size_t n)
+  {
+    return do_read_numbers(dest, n);
+  }
+
   //! Parse available input wihtout blocking.
   //! Return true if more input is needed to determine
   //! whether terminator (end) has been reached.
   bool expecting();
+
+protected:
+  //! Read the current value into dest and advance past it.
+  //! Return false at terminator or on failure.
+  bool read_next(int64_t & dest);
+  bool read_next(double & dest);
 };
 
 ////////////////////////////////////////
@@ -413,44 +492,269 @@ void jios_read(ijvalue & ij, std::back_insert_iterator<Container> it)
   while (!ija.at_end()) {
     typename Container::value_type v;
     ija >> v;
-    *it = v;
+    *it = std::move(v);
     ++it;
   }
 }
 
-template<class T>
-void jios_read(ijvalue & ij, std::vector<T> & container)
+namespace detail {
+
+//! Read array elements directly into elements emplaced at the back
+template<class Container>
+void read_emplace_back(ijarray & ija, Container & container)
+{
+  while (!ija.at_end()) {
+    container.emplace_back();
+    ija >> container.back();
+  }
+}
+
+template<class Set>
+void read_set(ijvalue & ij, Set & container)
+{
+  ijarray ija = ij.array();
+  while (!ija.at_end()) {
+    typename Set::value_type v;
+    ija >> v;
+    container.insert(std::move(v));
+  }
+}
+
+template<class Map>
+void read_map(ijobject & ijo, Map & container)
+{
+  while (!ijo.at_end()) {
+    std::pair<typename Map::key_type, typename Map::mapped_type> keyvalue;
+    ijo >> keyvalue;
+    container.insert(std::move(keyvalue));
+  }
+}
+
+} // namespace detail
+
+template<class T, class Alloc>
+void jios_read(ijvalue & ij, std::vector<T, Alloc> & container)
+{
+  container.clear();
+  ijarray ija = ij.array();
+  container.reserve(ija.size_hint());
+  detail::read_emplace_back(ija, container);
+}
+
+template<class Alloc>
+void jios_read(ijvalue & ij, std::vector<bool, Alloc> & container)
 {
   container.clear();
   jios::jios_read(ij, std::back_inserter(container));
 }
 
+void jios_read(ijvalue & ij, std::vector<int64_t> & dest);
+void jios_read(ijvalue & ij, std::vector<int32_t> & dest);
+void jios_read(ijvalue & ij, std::vector<double> & dest);
+void jios_read(ijvalue & ij, std::vector<float> & dest);
+
+namespace detail {
+
+//! Append all remaining numeric elements of ija to dest
+template<class T>
+void append_numbers(ijarray & ija, std::vector<T> & dest)
+{
+  std::size_t chunk = std::max<std::size_t>(ija.size_hint(), 16);
+  while (!ija.at_end()) {
+    std::size_t old = dest.size();
+    dest.resize(old + chunk);
+    dest.resize(old + ija.read_numbers(dest.data() + old, chunk));
+    chunk = std::max<std::size_t>(dest.size(), 16);
+  }
+}
+
+} // namespace detail
+
+//! Numeric matrix from an array of equal length numeric arrays
+
+template<class T>
+struct row_major
+{
+  std::vector<T> data;
+  std::size_t rows = 0;
+  std::size_t cols = 0;
+
+  T & operator () (std::size_t r, std::size_t c) { return data[r * cols + c]; }
+};
+
+template<class T>
+void jios_read(ijvalue & ij, row_major<T> & dest)
+{
+  dest.data.clear();
+  dest.rows = 0;
+  dest.cols = 0;
+  ijarray ija = ij.array();
+  while (!ija.at_end()) {
+    ijarray row = ija.get().array();
+    if (dest.rows == 0) {
+      detail::append_numbers(row, dest.data);
+      dest.cols = dest.data.size();
+    } else {
+      std::size_t old = dest.data.size();
+      dest.data.resize(old + dest.cols);
+      std::size_t got = row.read_numbers(dest.data.data() + old, dest.cols);
+      if (got != dest.cols || !row.at_end()) {
+        if (!row.fail()) { row.set_failbit(); }
+        return;
+      }
+    }
+    ++dest.rows;
+  }
+}
+
 template<class T>
 void jios_read(ijvalue & ij, std::list<T> & container)
 {
   container.clear();
-  jios::jios_read(ij, std::back_inserter(container));
+  ijarray ija = ij.array();
+  detail::read_emplace_back(ija, container);
 }
 
 template<class T>
 void jios_read(ijvalue & ij, std::deque<T> & container)
 {
   container.clear();
-  jios::jios_read(ij, std::back_inserter(container));
+  ijarray ija = ij.array();
+  detail::read_emplace_back(ija, container);
 }
 
+//! Fails unless the array has exactly N elements
 template<class T, std::size_t N>
 void jios_read(ijvalue & ij, std::array<T, N> & container)
 {
-  container.clear();
-  jios::jios_read(ij, std::back_inserter(container));
+  ijarray ija = ij.array();
+  std::size_t count = 0;
+  while (!ija.at_end()) {
+    if (count < N) {
+      ija >> container[count];
+    } else {
+      ija.skip();
+    }
+    ++count;
+  }
+  if (count != N && !ij.fail()) {
+    ij.set_failbit();
+  }
+}
+
+namespace detail {
+
+//! Read exactly n numeric elements in place
+template<class T>
+void read_number_array(ijvalue & ij, T * dest, std::size_t n)
+{
+  ijarray ija = ij.array();
+  if (ija.read_numbers(dest, n) != n || !ija.at_end()) {
+    if (!ij.fail()) { ij.set_failbit(); }
+  }
+}
+
+} // namespace detail
+
+template<std::size_t N>
+void jios_read(ijvalue & ij, std::array<int64_t, N> & container)
+{
+  detail::read_number_array(ij, container.data(), N);
+}
+
+template<std::size_t N>
+void jios_read(ijvalue & ij, std::array<int32_t, N> & container)
+{
+  detail::read_number_array(ij, container.data(), N);
+}
+
+template<std::size_t N>
+void jios_read(ijvalue & ij, std::array<double, N> & container)
+{
+  detail::read_number_array(ij, container.data(), N);
+}
+
+template<std::size_t N>
+void jios_read(ijvalue & ij, std::array<float, N> & container)
+{
+  detail::read_number_array(ij, container.data(), N);
+}
+
+namespace detail {
+
+//! Read tuple elements I to N - 1 from the next array elements,
+//! unrolled at compile time
+template<std::size_t I, std::size_t N>
+struct tuple_elements_reader
+{
+  template<class Tuple>
+  static void read(ijarray & ija, Tuple & dest)
+  {
+    if (ija.at_end()) {
+      if (!ija.fail()) { ija.set_failbit(); }
+      return;
+    }
+    ija >> std::get<I>(dest);
+    tuple_elements_reader<I + 1, N>::read(ija, dest);
+  }
+};
+
+template<std::size_t N>
+struct tuple_elements_reader<N, N>
+{
+  template<class Tuple>
+  static void read(ijarray &, Tuple &) {}
+};
+
+template<class Tuple>
+void read_tuple(ijvalue & ij, Tuple & dest)
+{
+  ijarray ija = ij.array();
+  tuple_elements_reader<0, std::tuple_size<Tuple>::value>::read(ija, dest);
+  if (!ij.fail() && !ija.at_end()) {
+    ij.set_failbit();
+  }
+}
+
+} // namespace detail
+
+//! Tuples and pairs are arrays of exactly as many elements
+template<class... Types>
+void jios_read(ijvalue & ij, std::tuple<Types...> & dest)
+{
+  detail::read_tuple(ij, dest);
+}
+
+template<class T1, class T2>
+void jios_read(ijvalue & ij, std::pair<T1, T2> & dest)
+{
+  detail::read_tuple(ij, dest);
 }
 
 template<class T>
 void jios_read(ijvalue & ij, std::forward_list<T> & container)
 {
   container.clear();
-  jios::jios_read(ij, std::back_inserter(container));
+  ijarray ija = ij.array();
+  auto it = container.before_begin();
+  while (!ija.at_end()) {
+    it = container.emplace_after(it);
+    ija >> *it;
+  }
+}
+
+template<class T>
+void jios_read(ijvalue & ij, std::set<T> & container)
+{
+  container.clear();
+  detail::read_set(ij, container);
+}
+
+template<class T>
+void jios_read(ijvalue & ij, std::unordered_set<T> & container)
+{
+  container.clear();
+  detail::read_set(ij, container);
 }
 
 template<class KeyT, class ValT>
@@ -458,13 +762,17 @@ void jios_read(ijvalue & ij, std::map<KeyT, ValT> & container)
 {
   container.clear();
   ijobject ijo = ij.object();
-  while (!ijo.at_end()) {
-    std::pair<KeyT, ValT> keyvalue;
-    ijo >> keyvalue;
-    container.insert(keyvalue);
-  }
+  detail::read_map(ijo, container);
 }
 
+template<class KeyT, class ValT>
+void jios_read(ijvalue & ij, std::unordered_map<KeyT, ValT> & container)
+{
+  container.clear();
+  ijobject ijo = ij.object();
+  container.reserve(ijo.size_hint());
+  detail::read_map(ijo, container);
+}
 
 } // namespace
 
@@ -12,6 +12,9 @@
 #include <forward_list>
 #include <array>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 #include <boost/range/iterator_range.hpp>
@@ -40,6 +43,9 @@ public:
 
   bool at_end() const;
 
+  //! Whether the sink failed to write, such as on an ostream error
+  bool fail() const;
+
 protected:
   std::shared_ptr<ojsink> pimpl_;
 };
@@ -72,6 +78,12 @@ public:
   ojvalue & operator * ();
 
   ojvalue * operator -> ();
+
+  //! Write n numbers from src as consecutive elements
+  void write_numbers(int64_t const* src, std::size_t n);
+  void write_numbers(int32_t const* src, std::size_t n);
+  void write_numbers(double const* src, std::size_t n);
+  void write_numbers(float const* src, std::size_t n);
 };
 
 // ojobject
@@ -130,6 +142,17 @@ struct jios_write_exists<T, typename detail::find_jios_write<T>::tag>
   : std::true_type
 {};
 
+//! Number kept as JSON text, such as for arbitrary precision or decimal
+//! types, read and written without converting through int64_t or double.
+//! Writing text that is not a JSON number sets the failbit of the sink.
+
+struct number_text
+{
+  std::string text;
+};
+
+void jios_write(ojvalue & oj, number_text const& src);
+
 // ojvalue
 
 class ojvalue
@@ -170,6 +193,25 @@ public:
 
   void flush() { do_flush(); }
 
+  //! Mark the sink as failed, as reported by fail() of its streams,
+  //! such as on invalid values. Sinks without a failure state ignore it.
+  void set_failbit() { do_set_failbit(); }
+
+  //! Whether write_raw_json accepts the text of a value, which is an
+  //! array or object if structure is true.
+  bool accepts_raw_json(bool structure) const
+  {
+    return do_accepts_raw_json(structure);
+  }
+
+  //! Write the text of one valid JSON value as is
+  void write_raw_json(char const* p, std::size_t len)
+  {
+    BOOST_ASSERT(do_accepts_raw_json(p != nullptr && len > 0
+                                     && (*p == '[' || *p == '{')));
+    do_print_raw_json(p, len);
+  }
+
 protected:
   typedef std::istreambuf_iterator<char> string_iterator;
 
@@ -190,6 +232,10 @@ private:
   friend class ojsink;
 
   virtual void do_flush() = 0;
+  virtual void do_set_failbit() {}
+
+  virtual bool do_accepts_raw_json(bool) const { return false; }
+  virtual void do_print_raw_json(char const*, std::size_t) {}
 
   void write_string_value();
   std::stringstream buf_;
@@ -208,6 +254,12 @@ class ojsink
   virtual void do_terminate() = 0;
   virtual bool do_is_terminator() const = 0;
   virtual void do_set_key(string_iterator, string_iterator) = 0;
+  virtual bool do_fail() const { return false; }
+
+protected:
+  //! Print consecutive values. Default prints each value separately.
+  virtual void do_print_numbers(int64_t const* src, std::size_t n);
+  virtual void do_print_numbers(double const* src, std::size_t n);
 };
 
 void endj(ojstream & oj);
@@ -377,6 +429,38 @@ void jios_write(ojvalue & oj, std::vector<T> const& cont)
   jios::jios_write(oj, boost::make_iterator_range(cont));
 }
 
+namespace detail {
+
+template<class T>
+void write_number_array(ojvalue & oj, T const* src, std::size_t n)
+{
+  ojarray oja = oj.array(true);
+  oja.write_numbers(src, n);
+  oja.terminate();
+}
+
+} // namespace detail
+
+inline void jios_write(ojvalue & oj, std::vector<int64_t> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), cont.size());
+}
+
+inline void jios_write(ojvalue & oj, std::vector<int32_t> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), cont.size());
+}
+
+inline void jios_write(ojvalue & oj, std::vector<double> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), cont.size());
+}
+
+inline void jios_write(ojvalue & oj, std::vector<float> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), cont.size());
+}
+
 template<class T>
 void jios_write(ojvalue & oj, std::list<T> const& cont)
 {
@@ -395,6 +479,74 @@ void jios_write(ojvalue & oj, std::array<T, N> const& cont)
   jios::jios_write(oj, boost::make_iterator_range(cont));
 }
 
+template<std::size_t N>
+void jios_write(ojvalue & oj, std::array<int64_t, N> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), N);
+}
+
+template<std::size_t N>
+void jios_write(ojvalue & oj, std::array<int32_t, N> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), N);
+}
+
+template<std::size_t N>
+void jios_write(ojvalue & oj, std::array<double, N> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), N);
+}
+
+template<std::size_t N>
+void jios_write(ojvalue & oj, std::array<float, N> const& cont)
+{
+  detail::write_number_array(oj, cont.data(), N);
+}
+
+namespace detail {
+
+//! Write tuple elements I to N - 1, unrolled at compile time
+template<std::size_t I, std::size_t N>
+struct tuple_elements_writer
+{
+  template<class Tuple>
+  static void write(ojarray & oja, Tuple const& src)
+  {
+    oja << std::get<I>(src);
+    tuple_elements_writer<I + 1, N>::write(oja, src);
+  }
+};
+
+template<std::size_t N>
+struct tuple_elements_writer<N, N>
+{
+  template<class Tuple>
+  static void write(ojarray &, Tuple const&) {}
+};
+
+template<class Tuple>
+void write_tuple(ojvalue & oj, Tuple const& src)
+{
+  ojarray oja = oj.array();
+  tuple_elements_writer<0, std::tuple_size<Tuple>::value>::write(oja, src);
+  oja.terminate();
+}
+
+} // namespace detail
+
+//! Tuples and pairs are written as arrays
+template<class... Types>
+void jios_write(ojvalue & oj, std::tuple<Types...> const& src)
+{
+  detail::write_tuple(oj, src);
+}
+
+template<class T1, class T2>
+void jios_write(ojvalue & oj, std::pair<T1, T2> const& src)
+{
+  detail::write_tuple(oj, src);
+}
+
 template<class T>
 void jios_write(ojvalue & oj, std::forward_list<T> const& cont)
 {
@@ -412,6 +564,28 @@ void jios_write(ojvalue & oj, std::map<KeyT, ValT> const& container)
   ojo.terminate();
 }
 
+template<class KeyT, class ValT>
+void jios_write(ojvalue & oj, std::unordered_map<KeyT, ValT> const& container)
+{
+  ojobject ojo = oj.object(true);
+  for (auto const& keyvalue : container) {
+    ojo << keyvalue;
+  }
+  ojo.terminate();
+}
+
+template<class T>
+void jios_write(ojvalue & oj, std::set<T> const& cont)
+{
+  jios::jios_write(oj, boost::make_iterator_range(cont));
+}
+
+template<class T>
+void jios_write(ojvalue & oj, std::unordered_set<T> const& cont)
+{
+  jios::jios_write(oj, boost::make_iterator_range(cont));
+}
+
 
 } // namespace
 
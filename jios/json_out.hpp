@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <ostream>
+#include <string>
 #include <jios/jout.hpp>
 
 namespace jios {
@@ -13,6 +14,13 @@ namespace jios {
 ojstream json_out(std::ostream & os, char delim = EOF);
 ojstream json_out(std::shared_ptr<std::ostream> const&, char delim = EOF);
 
+//! Pretty JSON indenting each nesting level by the indent string
+ojstream json_out(std::ostream & os, std::string const& indent,
+                  char delim = EOF);
+ojstream json_out(std::shared_ptr<std::ostream> const&,
+                  std::string const& indent,
+                  char delim = EOF);
+
 ojstream lined_json_out(std::ostream & os);
 ojstream lined_json_out(std::shared_ptr<std::ostream> const&,
                         char delim = EOF);
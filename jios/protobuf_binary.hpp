@@ -0,0 +1,82 @@
+#ifndef JIOS_PROTOBUF_BINARY_HPP
+#define JIOS_PROTOBUF_BINARY_HPP
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <jios/jin.hpp>
+
+namespace jios {
+
+
+//! Encodes JSON objects as protobuf binary messages by walking the
+//! message descriptor, without building Message objects. Accepts the
+//! JSON that jios_read accepts for messages, and also enum values by
+//! name or number. Fields are encoded in the order of the JSON keys.
+
+class proto_encoder
+  : boost::noncopyable
+{
+public:
+  explicit proto_encoder(google::protobuf::Descriptor const* desc);
+
+  //! Binary message of the JSON object src, valid until the next call.
+  //! Sets the failbit of src on unknown keys, mismatched values or
+  //! missing required fields.
+  std::string const& encode(ijvalue & src);
+
+private:
+  void encode_message(ijvalue & src,
+                      google::protobuf::Descriptor const* desc,
+                      std::size_t depth);
+  void encode_field(ijvalue & src,
+                    google::protobuf::FieldDescriptor const* field,
+                    std::size_t depth);
+  void encode_field_value(ijvalue & src,
+                          google::protobuf::FieldDescriptor const* field,
+                          std::size_t depth);
+  bool encode_scalar(ijvalue & src,
+                     google::protobuf::FieldDescriptor const* field,
+                     std::string & dest);
+  int required_count(google::protobuf::Descriptor const* desc);
+
+  google::protobuf::Descriptor const* const desc_;
+  //! Output of each nesting depth, kept to reuse their capacity
+  std::vector<std::string> levels_;
+  std::string text_;
+  std::unordered_map<google::protobuf::Descriptor const*, int> required_;
+};
+
+//! Write up to max_count values of src as length-delimited messages of
+//! type desc, as written by SerializeDelimitedToOstream. Returns the
+//! number of messages written.
+std::size_t write_delimited(ijstream & src,
+                            google::protobuf::Descriptor const* desc,
+                            google::protobuf::io::CodedOutputStream & out,
+                            std::size_t max_count
+                                = std::numeric_limits<std::size_t>::max());
+
+//! ijstream of length-delimited protobuf binary messages of type desc,
+//! such as written by SerializeDelimitedToOstream. Messages are read as
+//! JSON objects like those written by jios_write for messages, without
+//! building Message objects. Repeated fields are arrays of all the
+//! entries of the field, singular scalar fields take their last entry,
+//! enum values are their names and unknown fields are skipped. A
+//! singular message field with several entries, or a message longer
+//! than max_size bytes, sets the failbit. uint64 values above INT64_MAX
+//! read as text or double only. Values are valid until the stream
+//! advances. desc must outlive the stream.
+ijstream protobuf_delimited_in(std::istream & is,
+                               google::protobuf::Descriptor const* desc,
+                               std::size_t max_size = 64 << 20);
+
+
+} // namespace
+
+#endif
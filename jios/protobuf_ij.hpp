@@ -2,8 +2,14 @@
 #define CEL_JIOS_PROTOBUF_IJ_HPP
 
 #include <istream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <google/protobuf/arena.h>
 #include <google/protobuf/message.h>
 #include <jios/jin.hpp>
+#include <jios/protobuf_projection.hpp>
 
 namespace jios {
 
@@ -11,6 +17,70 @@ void merge_proto_type(ijvalue & ij, google::protobuf::Message & pro);
 
 void jios_read(ijvalue & ij, google::protobuf::Message & pro);
 
+//! Read only the fields of a message selected by a projection, skipping
+//! other fields. Unlike reading whole messages, required fields outside
+//! the projection may be missing.
+void jios_read(ijvalue & ij,
+               projected_ref<google::protobuf::Message> const& dest);
+
+//! Arena for batches of messages read by read_batch. Each batch frees
+//! the messages of the previous one at once. The first block of the
+//! arena is owned by proto_arena and grows to the space of the largest
+//! batch, so that batches of similar size stop allocating from the heap.
+
+class proto_arena
+  : boost::noncopyable
+{
+public:
+  static std::size_t const default_block_size = 1 << 16;
+
+  explicit proto_arena(std::size_t initial_block_size = default_block_size);
+
+  ~proto_arena();
+
+  //! Destroy all messages on the arena
+  void reset();
+
+  google::protobuf::Arena * get() { return arena_.get(); }
+
+  std::size_t block_size() const { return block_.size(); }
+
+private:
+  std::vector<char> block_;
+  std::unique_ptr<google::protobuf::Arena> arena_;
+};
+
+//! Reset arena and read up to max_count messages from src into dest,
+//! as messages of the type of prototype created on arena. Messages in
+//! dest are valid until the next reset of arena. Returns the number of
+//! messages read.
+std::size_t read_batch(ijstream & src,
+                       proto_arena & arena,
+                       google::protobuf::Message const& prototype,
+                       std::vector<google::protobuf::Message *> & dest,
+                       std::size_t max_count
+                           = std::numeric_limits<std::size_t>::max());
+
+//! Same as above for generated message type T, read through
+//! protoc-gen-jios overloads where included
+template<class T>
+std::size_t read_batch(ijstream & src,
+                       proto_arena & arena,
+                       std::vector<T *> & dest,
+                       std::size_t max_count
+                           = std::numeric_limits<std::size_t>::max())
+{
+  arena.reset();
+  dest.clear();
+  while (dest.size() < max_count && !src.at_end()) {
+    T * pro = google::protobuf::Arena::CreateMessage<T>(arena.get());
+    src.get().read(*pro);
+    if (src.fail()) break;
+    dest.push_back(pro);
+  }
+  return dest.size();
+}
+
 } // namespace
 
 #endif
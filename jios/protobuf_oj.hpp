@@ -5,12 +5,24 @@
 #include <boost/filesystem/path.hpp>
 #include <google/protobuf/message.h>
 #include <jios/jout.hpp>
+#include <jios/protobuf_projection.hpp>
 
 namespace jios {
 
 
 void jios_write(ojvalue & oj, google::protobuf::Message const& pro);
 
+//! Write only the fields of a message selected by a projection
+void jios_write(ojvalue & oj,
+                projected_ref<google::protobuf::Message const> const& src);
+
+//! ojstream setting the fields of dest as values are written, without
+//! JSON text. Each top-level object written replaces the contents of
+//! dest. Accepts the JSON that jios_read accepts for messages, and also
+//! enum values by name or number. Fails on unknown keys, mismatched
+//! values or missing required fields, discarding the rest of the value.
+ojstream protobuf_out(google::protobuf::Message & dest);
+
 
 } // namespace
 
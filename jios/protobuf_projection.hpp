@@ -0,0 +1,95 @@
+#ifndef JIOS_PROTOBUF_PROJECTION_HPP
+#define JIOS_PROTOBUF_PROJECTION_HPP
+
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/field_mask.pb.h>
+
+namespace jios {
+
+
+//! Fields of a message type selected by field mask paths such as "a.b".
+//! Paths are compiled into a table per selected message type, indexed
+//! by field index, so selecting a field is a lookup. Selecting a
+//! message field selects all of its fields. Paths may continue through
+//! repeated message fields, selecting fields of every element. Reading
+//! through a projection requires the required fields it selects.
+
+class proto_projection
+{
+public:
+  //! Selection of fields not in any path
+  static int const none = -1;
+
+  //! Selection of fields ending a path, with all their fields
+  static int const all = -2;
+
+  //! Throws std::invalid_argument if a path does not name a field
+  proto_projection(google::protobuf::Descriptor const* desc,
+                   std::vector<std::string> const& paths);
+
+  proto_projection(google::protobuf::Descriptor const* desc,
+                   google::protobuf::FieldMask const& mask);
+
+  google::protobuf::Descriptor const* descriptor() const
+  {
+    return nodes_[0].desc;
+  }
+
+  //! Selection of field of the message type of node, the root node
+  //! being 0: none, all, or the node selecting fields of its message
+  int select(int node, google::protobuf::FieldDescriptor const* field) const
+  {
+    return nodes_[node].fields[field->index()];
+  }
+
+  //! Required fields of the message type of node that it selects
+  std::vector<google::protobuf::FieldDescriptor const*> const&
+      required(int node) const
+  {
+    return nodes_[node].required;
+  }
+
+private:
+  struct node
+  {
+    google::protobuf::Descriptor const* desc;
+    std::vector<int> fields;
+    std::vector<google::protobuf::FieldDescriptor const*> required;
+  };
+
+  int add_node(google::protobuf::Descriptor const* desc);
+  void add_path(std::string const& path);
+
+  std::vector<node> nodes_;
+};
+
+//! Reference to a message to write or read through a projection, as by
+//! jios_write(oj, projected(message, projection))
+
+template<class Message>
+struct projected_ref
+{
+  Message & message;
+  proto_projection const& projection;
+};
+
+inline projected_ref<google::protobuf::Message const>
+    projected(google::protobuf::Message const& src,
+              proto_projection const& projection)
+{
+  return projected_ref<google::protobuf::Message const>{src, projection};
+}
+
+inline projected_ref<google::protobuf::Message>
+    projected(google::protobuf::Message & src,
+              proto_projection const& projection)
+{
+  return projected_ref<google::protobuf::Message>{src, projection};
+}
+
+
+} // namespace
+
+#endif
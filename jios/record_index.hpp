@@ -0,0 +1,90 @@
+#ifndef JIOS_RECORD_INDEX_HPP
+#define JIOS_RECORD_INDEX_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include <jios/jin.hpp>
+
+namespace jios {
+
+
+//! Byte offsets of records in JSON input, for random access without
+//! parsing everything before a record. Records are the top-level values
+//! of a stream (such as NDJSON) or the elements of a single top-level
+//! array. Only every stride-th record offset is kept.
+
+class record_index
+{
+public:
+  record_index();
+
+  //! Whether records are the elements of a top-level array
+  bool array() const { return array_; }
+
+  std::size_t stride() const { return stride_; }
+
+  //! Number of records
+  std::size_t size() const { return count_; }
+
+  //! Offsets of records 0, stride, 2 * stride, ...
+  std::vector<std::uint64_t> const& offsets() const { return offsets_; }
+
+  //! Offset just past the last record
+  std::uint64_t end_offset() const { return end_; }
+
+  //! Offset to start reading at for record n, and number of records to
+  //! skip from there. Records past the end locate to end_offset.
+  std::pair<std::uint64_t, std::size_t> locate(std::size_t n) const;
+
+  //! Range [first, last) of records starting in the byte range
+  //! [begin, end), at stride granularity. Ranges of adjacent byte ranges
+  //! are adjacent, so byte ranges partition records for parallel reads.
+  std::pair<std::size_t, std::size_t>
+      records_in(std::uint64_t begin, std::uint64_t end) const;
+
+  //! Write as sidecar file contents
+  void save(std::ostream & os) const;
+
+  //! Read sidecar file contents. Sets failbit of is if invalid.
+  void load(std::istream & is);
+
+private:
+  friend record_index build_record_index(std::istream & is,
+                                         std::size_t stride);
+
+  bool array_;
+  std::size_t stride_;
+  std::size_t count_;
+  std::vector<std::uint64_t> offsets_;
+  std::uint64_t end_;
+};
+
+//! Index records of uncompressed JSON input read to its end, with a
+//! structural scan not parsing values. Offsets count from the current
+//! position, which should be the start of input.
+//! Throws std::runtime_error if input is not a stream of JSON values
+//! or a single array.
+record_index build_record_index(std::istream & is, std::size_t stride = 1);
+
+//! Stream of count records, starting at record first, of seekable input
+//! indexed by idx. Input positions are relative to the start of input.
+ijstream indexed_json_in(std::shared_ptr<std::istream> const& p_is,
+                         record_index const& idx,
+                         std::size_t first,
+                         std::size_t count
+                             = std::numeric_limits<std::size_t>::max());
+ijstream indexed_json_in(std::istream & is,
+                         record_index const& idx,
+                         std::size_t first,
+                         std::size_t count
+                             = std::numeric_limits<std::size_t>::max());
+
+
+} // namespace
+
+#endif
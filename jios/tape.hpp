@@ -0,0 +1,102 @@
+#ifndef JIOS_TAPE_HPP
+#define JIOS_TAPE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <jios/jin.hpp>
+#include <jios/jout.hpp>
+
+namespace jios {
+
+
+//! Parsed JSON-ish values stored flat in a contiguous array of tagged
+//! 64-bit words plus an arena holding string contents.
+//! A tape is filled once (e.g. via tape_out or jios_read) and can then
+//! be read any number of times with tape_in.
+
+class tape
+{
+public:
+  typedef std::uint64_t word;
+
+  //! Top byte of each word. Payload is the low 56 bits.
+  //!   null, jfalse, jtrue : no payload
+  //!   integer, real       : next word holds the 64 value bits
+  //!   string, key         : payload is arena offset, next word is length
+  //!   array, object       : payload is index of the matching end word
+  //!   end                 : payload is the number of members
+  enum class tag : unsigned char {
+    null,
+    jfalse,
+    jtrue,
+    integer,
+    real,
+    string,
+    key,
+    array,
+    object,
+    end
+  };
+
+  static const unsigned payload_bits = 56;
+  static const word payload_mask = (word(1) << payload_bits) - 1;
+
+  static word make_word(tag t, word payload = 0)
+  {
+    return (word(t) << payload_bits) | (payload & payload_mask);
+  }
+
+  static tag tag_of(word w) { return tag(w >> payload_bits); }
+  static word payload_of(word w) { return w & payload_mask; }
+
+  void clear() { words_.clear(); arena_.clear(); }
+
+  bool empty() const { return words_.empty(); }
+
+  std::vector<word> const& words() const { return words_; }
+  std::string const& arena() const { return arena_; }
+
+  //! Index of the word following the value starting at idx
+  std::size_t next(std::size_t idx) const
+  {
+    word w = words_[idx];
+    switch (tag_of(w)) {
+      case tag::integer:
+      case tag::real:
+      case tag::string:
+      case tag::key:
+        return idx + 2;
+      case tag::array:
+      case tag::object:
+        return payload_of(w) + 1;
+      default:
+        break;
+    }
+    return idx + 1;
+  }
+
+private:
+  friend class tape_ojnode;
+
+  std::vector<word> words_;
+  std::string arena_;
+};
+
+//! ojstream appending values written to it onto a tape
+ojstream tape_out(tape & dest);
+
+//! ijstream of the values on a tape, readable independently any
+//! number of times. Throws std::invalid_argument if src is null.
+ijstream tape_in(std::shared_ptr<tape const> const& src);
+ijstream tape_in(tape const& src);
+
+//! Record a single JSON-ish value as the only value on a tape
+void jios_read(ijvalue & ij, tape & dest);
+
+
+} // namespace
+
+#endif
+
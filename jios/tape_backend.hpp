@@ -0,0 +1,378 @@
+#ifndef JIOS_TAPE_BACKEND_HPP
+#define JIOS_TAPE_BACKEND_HPP
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <boost/noncopyable.hpp>
+#include <jios/tape.hpp>
+#include <jios/basic_stream.hpp>
+
+namespace jios {
+
+
+//! Final tape back-end classes, for use with basic_ijstream and
+//! basic_ojstream when the tape back-end is known at compile time.
+
+class tape_ojnode final
+  : public ojsink
+  , boost::noncopyable
+{
+public:
+  //! root node appending top-level values
+  tape_ojnode(tape & dest)
+    : dest_(dest)
+    , start_(0)
+    , count_(0)
+    , root_(true)
+    , terminated_(false)
+  {}
+
+  //! node of array or object that started at word index start
+  tape_ojnode(tape & dest, std::size_t start)
+    : dest_(dest)
+    , start_(start)
+    , count_(0)
+    , root_(false)
+    , terminated_(false)
+  {}
+
+  void print_null() { push(tape::tag::null); }
+  void print(int64_t value) { push_bits(tape::tag::integer, value); }
+  void print(double value) { push_bits(tape::tag::real, value); }
+  void print(bool value)
+  {
+    push(value ? tape::tag::jtrue : tape::tag::jfalse);
+  }
+  void print_string(char const* p, std::size_t len)
+  {
+    push_text(tape::tag::string, p, p + len);
+    ++count_;
+  }
+
+  void set_key(char const* p, std::size_t len)
+  {
+    push_text(tape::tag::key, p, p + len);
+  }
+
+  std::shared_ptr<tape_ojnode> begin_array(bool = false)
+  {
+    return begin_struct(tape::tag::array);
+  }
+
+  std::shared_ptr<tape_ojnode> begin_object(bool = false)
+  {
+    return begin_struct(tape::tag::object);
+  }
+
+  void terminate();
+
+private:
+  void do_print_null() override { print_null(); }
+  void do_print(int64_t value) override { print(value); }
+  void do_print(double value) override { print(value); }
+  void do_print(bool value) override { print(value); }
+  void do_print(string_iterator it, string_iterator end) override
+  {
+    push_text(tape::tag::string, it, end);
+    ++count_;
+  }
+
+  ojarray do_begin_array(bool multimode) override
+  {
+    return ojarray(begin_array(multimode));
+  }
+
+  ojobject do_begin_object(bool multimode) override
+  {
+    return ojobject(begin_object(multimode));
+  }
+
+  void do_set_key(string_iterator it, string_iterator end) override
+  {
+    push_text(tape::tag::key, it, end);
+  }
+
+  void do_flush() override {}
+  void do_terminate() override { terminate(); }
+  bool do_is_terminator() const override { return terminated_; }
+
+  void push(tape::tag t, tape::word payload = 0)
+  {
+    dest_.words_.push_back(tape::make_word(t, payload));
+    ++count_;
+  }
+
+  template<typename T>
+  void push_bits(tape::tag t, T value)
+  {
+    tape::word bits;
+    static_assert(sizeof(bits) == sizeof(value), "64-bit values expected");
+    std::memcpy(&bits, &value, sizeof(bits));
+    push(t);
+    dest_.words_.push_back(bits);
+  }
+
+  //! Append string or key words, not counting as a value
+  template<typename Iter>
+  void push_text(tape::tag t, Iter it, Iter end)
+  {
+    std::size_t offset = dest_.arena_.size();
+    dest_.arena_.append(it, end);
+    dest_.words_.push_back(tape::make_word(t, offset));
+    dest_.words_.push_back(dest_.arena_.size() - offset);
+  }
+
+  std::shared_ptr<tape_ojnode> begin_struct(tape::tag t);
+
+  tape & dest_;
+  std::size_t const start_;
+  std::size_t count_;
+  bool const root_;
+  bool terminated_;
+};
+
+class tape_state final : public ijstate
+{
+public:
+  tape_state() : failbit_(false) {}
+
+  bool failed() const { return failbit_; }
+
+private:
+  bool do_get_failbit() const override { return failbit_; }
+  void do_set_failbit() override { failbit_ = true; }
+
+  bool failbit_;
+};
+
+class tape_ijsource;
+
+class tape_value final : public ijpair
+{
+public:
+  tape_value(std::shared_ptr<tape_state> const& p_state,
+             std::shared_ptr<tape const> const& p_tape)
+    : p_state_(p_state)
+    , p_tape_(p_tape)
+    , idx_(0)
+    , key_idx_(0)
+    , has_key_(false)
+  {}
+
+  void reset(std::size_t idx) { idx_ = idx; has_key_ = false; }
+
+  void reset(std::size_t key_idx, std::size_t idx)
+  {
+    key_idx_ = key_idx;
+    idx_ = idx;
+    has_key_ = true;
+  }
+
+  bool failed() const { return p_state_->failed(); }
+
+  bool parse(int64_t & dest)
+  {
+    if (head_tag() != tape::tag::integer) return mismatch();
+    tape::word w = bits();
+    std::memcpy(&dest, &w, sizeof(dest));
+    return true;
+  }
+
+  bool parse(double & dest)
+  {
+    switch (head_tag()) {
+      case tape::tag::real:
+        {
+          tape::word w = bits();
+          std::memcpy(&dest, &w, sizeof(dest));
+        }
+        return true;
+      case tape::tag::integer:
+        {
+          int64_t i;
+          tape::word w = bits();
+          std::memcpy(&i, &w, sizeof(i));
+          dest = i;
+        }
+        return true;
+      default:
+        break;
+    }
+    return mismatch();
+  }
+
+  bool parse(bool & dest)
+  {
+    switch (head_tag()) {
+      case tape::tag::jtrue:  dest = true; return true;
+      case tape::tag::jfalse: dest = false; return true;
+      default:
+        break;
+    }
+    return mismatch();
+  }
+
+  bool parse(std::string & dest);
+
+  //! Source of the members of this array or object.
+  //! On type mismatch, sets failbit and returns an empty source.
+  std::shared_ptr<tape_ijsource> sub_source(bool object);
+
+private:
+  tape::word head() const { return p_tape_->words()[idx_]; }
+  tape::tag head_tag() const { return tape::tag_of(head()); }
+  tape::word bits() const { return p_tape_->words()[idx_ + 1]; }
+
+  bool mismatch() { this->set_failbit(); return false; }
+
+  bool parse_text(const char * & p, std::size_t & len,
+                  std::string & tmp) const;
+
+  ijstate & do_state() override { return *p_state_; }
+  ijstate const& do_state() const override { return *p_state_; }
+
+  json_type do_type() const override;
+
+  void do_parse(int64_t & dest) override { parse(dest); }
+  void do_parse(double & dest) override { parse(dest); }
+  void do_parse(bool & dest) override { parse(dest); }
+  void do_parse(std::string & dest) override { parse(dest); }
+  void do_parse(buffer_iterator dest) override;
+
+  ijarray do_begin_array() override;
+  ijobject do_begin_object() override;
+
+  std::string do_key() const override;
+  boost::string_ref do_key_ref() const override;
+
+  std::shared_ptr<tape_state> p_state_;
+  std::shared_ptr<tape const> p_tape_;
+  std::size_t idx_;
+  std::size_t key_idx_;
+  bool has_key_;
+  //! Last sub source, reused when no longer referenced elsewhere
+  std::shared_ptr<tape_ijsource> p_spare_;
+};
+
+class tape_ijsource final : public ijsource
+{
+public:
+  typedef tape_value value_type;
+
+  tape_ijsource(std::shared_ptr<tape_state> const& p_state,
+                std::shared_ptr<tape const> const& p_tape,
+                std::size_t begin,
+                std::size_t end,
+                bool in_object)
+    : value_(p_state, p_tape)
+    , p_tape_(p_tape)
+    , pos_(begin)
+    , end_(end)
+    , in_object_(in_object)
+    , idx_(0)
+  {
+    init();
+  }
+
+  value_type & value() { return value_; }
+
+  //! Restart at the values in [begin, end)
+  void reset(std::size_t begin, std::size_t end, bool in_object)
+  {
+    pos_ = begin;
+    end_ = end;
+    in_object_ = in_object;
+    idx_ = 0;
+    init();
+  }
+
+  bool at_terminator() const { return pos_ >= end_ || value_.failed(); }
+
+  void next()
+  {
+    pos_ = p_tape_->next(in_object_ ? pos_ + 2 : pos_);
+    ++idx_;
+    init();
+  }
+
+private:
+  ijstate & do_state() override { return value_.state(); }
+  ijstate const& do_state() const override { return value_.state(); }
+
+  ijpair & do_ref() override { return value_; }
+
+  bool do_is_terminator() override { return at_terminator(); }
+
+  void do_advance() override { next(); }
+
+  bool do_hint_multiline() const override
+  {
+    if (end_ >= p_tape_->words().size()) return false;
+    return tape::payload_of(p_tape_->words()[end_]) > 1;
+  }
+
+  std::size_t do_size_hint() const override
+  {
+    if (end_ >= p_tape_->words().size()) return 0;
+    std::size_t count = tape::payload_of(p_tape_->words()[end_]);
+    return (idx_ < count ? count - idx_ : 0);
+  }
+
+  bool do_expecting() override { return false; }
+
+  std::size_t do_read_numbers(int64_t * dest, std::size_t n) override
+  {
+    return read_tape_numbers(dest, n);
+  }
+
+  std::size_t do_read_numbers(double * dest, std::size_t n) override
+  {
+    return read_tape_numbers(dest, n);
+  }
+
+  template<typename T>
+  std::size_t read_tape_numbers(T * dest, std::size_t n)
+  {
+    BOOST_ASSERT(!in_object_);
+    std::size_t count = 0;
+    while (count < n && !at_terminator() && value_.parse(dest[count])) {
+      pos_ += 2;
+      ++idx_;
+      ++count;
+      init();
+    }
+    return count;
+  }
+
+  void init()
+  {
+    if (pos_ < end_) {
+      if (in_object_) {
+        value_.reset(pos_, pos_ + 2);
+      } else {
+        value_.reset(pos_);
+      }
+    }
+  }
+
+  tape_value value_;
+  std::shared_ptr<tape const> p_tape_;
+  std::size_t pos_;
+  std::size_t end_;
+  bool in_object_;
+  std::size_t idx_;
+};
+
+typedef basic_ijstream<tape_ijsource> static_tape_ijstream;
+typedef basic_ojstream<tape_ojnode> static_tape_ojstream;
+
+//! Statically dispatched versions of tape_in and tape_out
+static_tape_ijstream static_tape_in(std::shared_ptr<tape const> const& src);
+static_tape_ijstream static_tape_in(tape const& src);
+static_tape_ojstream static_tape_out(tape & dest);
+
+
+} // namespace
+
+#endif
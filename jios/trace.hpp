@@ -0,0 +1,156 @@
+#ifndef JIOS_TRACE_HPP
+#define JIOS_TRACE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#ifdef JIOS_WITH_SDT
+#include <sys/sdt.h>
+#endif
+
+namespace jios {
+
+
+//! Traced operations. Events nest: advance includes any parse and
+//! io_wait needed to reach the next value.
+enum class trace_event {
+  parse,    //! istream_parser parsing buffered input
+  io_wait,  //! waiting on an istream for more input
+  advance,  //! ijsource advancing past a value
+  write,    //! text sink emitting a value
+  flush     //! text sink flushing its ostream
+};
+
+std::size_t const trace_event_count = 5;
+
+//! Receiver of the duration of each traced operation
+
+class trace_hook
+{
+public:
+  virtual ~trace_hook() {}
+
+  virtual void record(trace_event e, std::chrono::nanoseconds elapsed) = 0;
+};
+
+//! Install hook for operations on the calling thread, returning the
+//! previous hook. A null hook disables tracing.
+trace_hook * set_trace_hook(trace_hook * hook);
+
+//! Install a hook for the lifetime of this object
+
+class scoped_trace_hook
+  : boost::noncopyable
+{
+public:
+  explicit scoped_trace_hook(trace_hook & hook)
+    : prev_(set_trace_hook(&hook))
+  {}
+
+  ~scoped_trace_hook() { set_trace_hook(prev_); }
+
+private:
+  trace_hook * const prev_;
+};
+
+//! Histogram of values with log-linear buckets, like HDR histograms,
+//! with relative precision of 1/16 over the full uint64_t range.
+
+class latency_histogram
+{
+public:
+  latency_histogram();
+
+  void record(std::uint64_t value);
+  void merge(latency_histogram const& other);
+  void reset();
+
+  std::uint64_t count() const { return count_; }
+  std::uint64_t min() const { return count_ ? min_ : 0; }
+  std::uint64_t max() const { return max_; }
+  double mean() const;
+
+  //! Highest value equivalent to the value at or below which percentile
+  //! percent of recorded values lie. Returns 0 if empty.
+  std::uint64_t value_at_percentile(double percentile) const;
+
+private:
+  static std::size_t const sub_bucket_bits = 4;
+  static std::size_t const sub_bucket_count = 1 << sub_bucket_bits;
+
+  static std::size_t bucket_of(std::uint64_t value);
+  static std::uint64_t highest_in_bucket(std::size_t bucket);
+
+  std::vector<std::uint64_t> counts_;
+  std::uint64_t count_;
+  std::uint64_t min_;
+  std::uint64_t max_;
+  double total_;
+};
+
+//! Hook recording nanosecond latencies of each event in a histogram
+
+class histogram_trace_hook : public trace_hook
+{
+public:
+  latency_histogram const& histogram(trace_event e) const
+  {
+    return histograms_[std::size_t(e)];
+  }
+
+  void reset();
+
+  void record(trace_event e, std::chrono::nanoseconds elapsed) override;
+
+private:
+  std::array<latency_histogram, trace_event_count> histograms_;
+};
+
+namespace detail {
+
+extern thread_local trace_hook * current_trace_hook;
+
+//! Trace the operation lasting for the lifetime of this object.
+//! Clock reads only happen while a hook is installed.
+
+class trace_scope
+  : boost::noncopyable
+{
+  typedef std::chrono::steady_clock clock;
+
+public:
+  explicit trace_scope(trace_event e)
+    : hook_(current_trace_hook)
+    , event_(e)
+  {
+#ifdef JIOS_WITH_SDT
+    DTRACE_PROBE1(jios, begin, int(e));
+#endif
+    if (hook_) { start_ = clock::now(); }
+  }
+
+  ~trace_scope()
+  {
+    if (hook_) {
+      hook_->record(event_, clock::now() - start_);
+    }
+#ifdef JIOS_WITH_SDT
+    DTRACE_PROBE1(jios, end, int(event_));
+#endif
+  }
+
+private:
+  trace_hook * const hook_;
+  trace_event const event_;
+  clock::time_point start_;
+};
+
+} // namespace detail
+
+
+} // namespace
+
+#endif
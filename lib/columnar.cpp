@@ -0,0 +1,431 @@
+#include <jios/columnar.hpp>
+
+#include <boost/assert.hpp>
+
+using namespace std;
+
+namespace jios {
+
+
+// column
+
+column::column(size_t domain, size_t max_dictionary_size)
+  : domain_(domain)
+  , max_dictionary_size_(max_dictionary_size)
+  , child_domain_(0)
+  , type_(json_type::jnull)
+  , size_(0)
+  , dictionary_encoded_(false)
+{
+}
+
+boost::string_ref column::string_at(size_t row) const
+{
+  BOOST_ASSERT(type_ == json_type::jstring && row < size_);
+  size_t i = (dictionary_encoded_ ? codes_[row] : row);
+  if (!valid(row) || i + 1 >= offsets_.size()) return boost::string_ref();
+  return boost::string_ref(bytes_.data() + offsets_[i],
+                           offsets_[i + 1] - offsets_[i]);
+}
+
+void column::pad_to(size_t row)
+{
+  while (size_ < row) {
+    push_placeholder();
+  }
+}
+
+bool column::begin_row(size_t row, json_type t)
+{
+  pad_to(row);
+  if (size_ != row) return false;
+  if (t == json_type::jnull || t == type_) return true;
+  if (type_ == json_type::jnull) {
+    set_type(t);
+    return true;
+  }
+  if (type_ == json_type::jinteger && t == json_type::jfloat) {
+    reals_.assign(integers_.begin(), integers_.end());
+    integers_ = vector<int64_t>();
+    type_ = json_type::jfloat;
+    return true;
+  }
+  return (type_ == json_type::jfloat && t == json_type::jinteger);
+}
+
+//! Entry for a null or missing row, not marked valid
+void column::push_placeholder()
+{
+  switch (type_) {
+    case json_type::jbool:
+    case json_type::jinteger:
+      integers_.push_back(0);
+      break;
+    case json_type::jfloat:
+      reals_.push_back(0);
+      break;
+    case json_type::jstring:
+      if (dictionary_encoded_) {
+        codes_.push_back(0);
+      } else {
+        offsets_.push_back(bytes_.size());
+      }
+      break;
+    case json_type::jarray:
+      offsets_.push_back(offsets_.back());
+      break;
+    default:
+      break;
+  }
+  if (size_ % 8 == 0) { validity_.push_back(0); }
+  ++size_;
+}
+
+void column::push_valid()
+{
+  if (size_ % 8 == 0) { validity_.push_back(0); }
+  validity_[size_ / 8] |= (1 << (size_ % 8));
+  ++size_;
+}
+
+void column::push(int64_t value)
+{
+  if (type_ == json_type::jfloat) {
+    reals_.push_back(value);
+  } else {
+    integers_.push_back(value);
+  }
+  push_valid();
+}
+
+void column::push(double value)
+{
+  reals_.push_back(value);
+  push_valid();
+}
+
+void column::push(bool value)
+{
+  integers_.push_back(value);
+  push_valid();
+}
+
+void column::push(string const& value)
+{
+  if (dictionary_encoded_) {
+    auto it = lookup_.find(value);
+    if (it != lookup_.end()) {
+      codes_.push_back(it->second);
+      push_valid();
+      return;
+    }
+    if (lookup_.size() < max_dictionary_size_) {
+      uint32_t code = lookup_.size();
+      lookup_.emplace(value, code);
+      append_entry(value);
+      codes_.push_back(code);
+      push_valid();
+      return;
+    }
+    make_plain();
+  }
+  append_entry(value);
+  push_valid();
+}
+
+void column::push_list_end(uint64_t end)
+{
+  offsets_.push_back(end);
+  push_valid();
+}
+
+//! Set type of a column with only null rows so far
+void column::set_type(json_type t)
+{
+  BOOST_ASSERT(type_ == json_type::jnull);
+  type_ = t;
+  switch (t) {
+    case json_type::jbool:
+    case json_type::jinteger:
+      integers_.assign(size_, 0);
+      break;
+    case json_type::jfloat:
+      reals_.assign(size_, 0);
+      break;
+    case json_type::jstring:
+      dictionary_encoded_ = (max_dictionary_size_ > 0);
+      if (dictionary_encoded_) {
+        codes_.assign(size_, 0);
+        offsets_.assign(1, 0);
+      } else {
+        offsets_.assign(size_ + 1, 0);
+      }
+      break;
+    case json_type::jarray:
+      offsets_.assign(size_ + 1, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+void column::append_entry(boost::string_ref s)
+{
+  bytes_.append(s.data(), s.size());
+  offsets_.push_back(bytes_.size());
+}
+
+//! Switch from dictionary codes to a string per row
+void column::make_plain()
+{
+  vector<uint64_t> entries;
+  entries.swap(offsets_);
+  string dictionary;
+  dictionary.swap(bytes_);
+  offsets_.reserve(size_ + 1);
+  offsets_.push_back(0);
+  for (size_t row = 0; row < size_; ++row) {
+    if (valid(row)) {
+      uint32_t i = codes_[row];
+      bytes_.append(dictionary, entries[i], entries[i + 1] - entries[i]);
+    }
+    offsets_.push_back(bytes_.size());
+  }
+  codes_ = vector<uint32_t>();
+  lookup_.clear();
+  dictionary_encoded_ = false;
+}
+
+// column_table
+
+column_table::column_table(size_t max_dictionary_size)
+  : max_dictionary_size_(max_dictionary_size)
+  , domains_(1)
+  , failed_(false)
+{
+  domains_[0].rows = 0;
+}
+
+column const* column_table::find(string const& path) const
+{
+  auto it = columns_.find(path);
+  return (it == columns_.end() ? nullptr : &it->second);
+}
+
+void column_table::clear()
+{
+  columns_.clear();
+  domains_.resize(1);
+  domains_[0].rows = 0;
+  domains_[0].columns.clear();
+  failed_ = false;
+}
+
+//! Column at path, created if new, or nullptr if path is in a
+//! different domain, such as with keys containing "[]"
+column * column_table::at(string const& path, size_t domain)
+{
+  auto it = columns_.find(path);
+  if (it == columns_.end()) {
+    it = columns_.insert(make_pair(path,
+                                   column(domain, max_dictionary_size_))).first;
+    domains_[domain].columns.push_back(&it->second);
+  }
+  return (it->second.domain_ == domain ? &it->second : nullptr);
+}
+
+size_t column_table::new_domain()
+{
+  domains_.emplace_back();
+  domains_.back().rows = 0;
+  return domains_.size() - 1;
+}
+
+void column_table::end_row(size_t d)
+{
+  domain & dom = domains_[d];
+  ++dom.rows;
+  for (column * c : dom.columns) {
+    c->pad_to(dom.rows);
+  }
+}
+
+// columnar_ojnode
+
+//! Sink of the top-level values, or of an array or object, of records
+//! appended to a column_table
+
+class columnar_ojnode
+  : public ojsink
+  , public enable_shared_from_this<columnar_ojnode>
+  , boost::noncopyable
+{
+public:
+  //! root node appending each value as a record
+  columnar_ojnode(column_table & dest)
+    : table_(dest)
+    , in_object_(false)
+    , domain_(0)
+    , list_(nullptr)
+    , prefix_size_(0)
+    , terminated_(false)
+  {}
+
+  //! node of an array, with elements at path + "[]" in the child domain
+  //! of list, or of an object with members at path + "." + key
+  columnar_ojnode(column_table & dest,
+                  shared_ptr<columnar_ojnode> const& parent,
+                  string const& path,
+                  bool in_object,
+                  size_t domain,
+                  column * list)
+    : table_(dest)
+    , parent_(parent)
+    , in_object_(in_object)
+    , domain_(domain)
+    , list_(list)
+    , path_(path)
+    , terminated_(false)
+  {
+    if (in_object) {
+      if (!path_.empty()) { path_ += '.'; }
+    } else {
+      path_ += "[]";
+    }
+    prefix_size_ = path_.size();
+  }
+
+private:
+  //! Column of the next value if it can take type t
+  column * begin_value(json_type t)
+  {
+    if (table_.failed_) return nullptr;
+    column * c = table_.at(path_, domain_);
+    if (!c || !c->begin_row(table_.domains_[domain_].rows, t)) {
+      table_.failed_ = true;
+      return nullptr;
+    }
+    return c;
+  }
+
+  //! Complete the row of an array element or record
+  void end_value()
+  {
+    if (!in_object_ && !table_.failed_) {
+      table_.end_row(domain_);
+    }
+  }
+
+  template<typename T>
+  void print_value(json_type t, T const& value)
+  {
+    if (column * c = begin_value(t)) {
+      c->push(value);
+      end_value();
+    }
+  }
+
+  void do_print_null() override
+  {
+    if (begin_value(json_type::jnull)) {
+      end_value();
+    }
+  }
+
+  void do_print(int64_t value) override
+  {
+    print_value(json_type::jinteger, value);
+  }
+
+  void do_print(double value) override
+  {
+    print_value(json_type::jfloat, value);
+  }
+
+  void do_print(bool value) override
+  {
+    print_value(json_type::jbool, value);
+  }
+
+  void do_print(string_iterator it, string_iterator end) override
+  {
+    buf_.assign(it, end);
+    print_value(json_type::jstring, buf_);
+  }
+
+  ojarray do_begin_array(bool) override
+  {
+    column * c = begin_value(json_type::jarray);
+    size_t child = 0;
+    if (c) {
+      // domain 0 is records, never a child domain
+      if (c->child_domain_ == 0) {
+        c->child_domain_ = table_.new_domain();
+      }
+      child = c->child_domain_;
+    }
+    return ojarray(make_shared<columnar_ojnode>(
+        table_, shared_from_this(), path_, false, child, c));
+  }
+
+  ojobject do_begin_object(bool) override
+  {
+    return ojobject(make_shared<columnar_ojnode>(
+        table_, shared_from_this(), path_, true, domain_, nullptr));
+  }
+
+  void do_set_key(string_iterator it, string_iterator end) override
+  {
+    BOOST_ASSERT(in_object_);
+    path_.resize(prefix_size_);
+    path_.append(it, end);
+  }
+
+  void do_flush() override {}
+
+  void do_terminate() override
+  {
+    BOOST_ASSERT(!terminated_);
+    terminated_ = true;
+    if (!parent_) return;
+    if (list_ && !table_.failed_) {
+      list_->push_list_end(table_.domains_[domain_].rows);
+    }
+    parent_->end_value();
+  }
+
+  bool do_is_terminator() const override { return terminated_; }
+
+  bool do_fail() const override { return table_.failed_; }
+  void do_set_failbit() override { table_.failed_ = true; }
+
+  column_table & table_;
+  shared_ptr<columnar_ojnode> const parent_;
+  bool const in_object_;
+  size_t const domain_;
+  column * const list_;
+  string path_;
+  size_t prefix_size_;
+  string buf_;
+  bool terminated_;
+};
+
+ojstream columnar_out(column_table & dest)
+{
+  return shared_ptr<ojsink>(make_shared<columnar_ojnode>(dest));
+}
+
+size_t read_columns(ijstream & src, column_table & dest, size_t max_count)
+{
+  ojstream out = columnar_out(dest);
+  size_t count = 0;
+  while (count < max_count && !src.at_end() && !dest.fail()) {
+    jios_read(src.get(), out.put());
+    if (src.fail()) break;
+    ++count;
+  }
+  return count;
+}
+
+
+} // namespace
@@ -0,0 +1,748 @@
+
+#include <jios/compress.hpp>
+
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+#include <boost/core/null_deleter.hpp>
+#include <boost/throw_exception.hpp>
+#include <zlib.h>
+#ifdef JIOS_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
+
+using namespace std;
+
+namespace jios {
+
+
+namespace {
+
+size_t const compress_buffer_size = size_t(1) << 16;
+size_t const parallel_block_size = size_t(1) << 18;
+
+inline uInt clamp_uint(ptrdiff_t n)
+{
+  return uInt(min<ptrdiff_t>(n, ptrdiff_t(1) << 30));
+}
+
+// decoder
+
+class decoder
+{
+public:
+  virtual ~decoder() {}
+
+  //! Decode input at in into output at out, advancing both.
+  //! Return false if input is corrupt.
+  virtual bool decode(const char * & in, const char * in_end,
+                      char * & out, char * out_end) = 0;
+
+  //! Whether input decoded so far ends a complete compressed stream
+  virtual bool at_boundary() const = 0;
+};
+
+class gzip_decoder : public decoder
+{
+public:
+  gzip_decoder()
+    : boundary_(true)
+  {
+    memset(&z_, 0, sizeof(z_));
+    // adding 32 to window bits accepts both gzip and zlib headers
+    if (inflateInit2(&z_, 15 + 32) != Z_OK) {
+      BOOST_THROW_EXCEPTION(bad_alloc());
+    }
+  }
+
+  ~gzip_decoder() override { inflateEnd(&z_); }
+
+  bool decode(const char * & in, const char * in_end,
+              char * & out, char * out_end) override;
+
+  bool at_boundary() const override { return boundary_; }
+
+private:
+  z_stream z_;
+  bool boundary_;
+};
+
+bool gzip_decoder::decode(const char * & in, const char * in_end,
+                          char * & out, char * out_end)
+{
+  z_.next_in = (Bytef *)in;
+  z_.avail_in = clamp_uint(in_end - in);
+  z_.next_out = (Bytef *)out;
+  z_.avail_out = clamp_uint(out_end - out);
+  int rc = inflate(&z_, Z_NO_FLUSH);
+  bool consumed = ((const char *)z_.next_in != in);
+  in = (const char *)z_.next_in;
+  out = (char *)z_.next_out;
+  switch (rc) {
+    case Z_STREAM_END:
+      // concatenated gzip members may follow
+      inflateReset(&z_);
+      boundary_ = true;
+      return true;
+    case Z_OK:
+      if (consumed) { boundary_ = false; }
+      return true;
+    case Z_BUF_ERROR:
+      return true;
+  }
+  return false;
+}
+
+#ifdef JIOS_WITH_ZSTD
+
+class zstd_decoder : public decoder
+{
+public:
+  zstd_decoder()
+    : p_dctx_(ZSTD_createDCtx())
+    , boundary_(true)
+  {
+    if (!p_dctx_) {
+      BOOST_THROW_EXCEPTION(bad_alloc());
+    }
+  }
+
+  ~zstd_decoder() override { ZSTD_freeDCtx(p_dctx_); }
+
+  bool decode(const char * & in, const char * in_end,
+              char * & out, char * out_end) override
+  {
+    ZSTD_inBuffer ib = { in, size_t(in_end - in), 0 };
+    ZSTD_outBuffer ob = { out, size_t(out_end - out), 0 };
+    size_t rc = ZSTD_decompressStream(p_dctx_, &ob, &ib);
+    in += ib.pos;
+    out += ob.pos;
+    if (ZSTD_isError(rc)) return false;
+    if (ib.pos || ob.pos) { boundary_ = (rc == 0); }
+    return true;
+  }
+
+  bool at_boundary() const override { return boundary_; }
+
+private:
+  ZSTD_DCtx * const p_dctx_;
+  bool boundary_;
+};
+
+#endif
+
+// decode_istreambuf
+
+class decode_istreambuf : public streambuf
+{
+public:
+  decode_istreambuf(shared_ptr<istream> const& p_src,
+                    unique_ptr<decoder> && p_dec)
+    : p_src_(p_src)
+    , p_dec_(move(p_dec))
+    , in_buf_(compress_buffer_size)
+    , out_buf_(compress_buffer_size)
+    , in_pos_(in_buf_.data())
+    , in_end_(in_buf_.data())
+    , src_done_(false)
+    , finished_(false)
+  {
+    setg(out_buf_.data(), out_buf_.data(), out_buf_.data());
+  }
+
+protected:
+  int_type underflow() override;
+  streamsize xsgetn(char * s, streamsize n) override;
+  streamsize showmanyc() override;
+
+private:
+  void refill();
+  streamsize produce(char * s, streamsize n);
+
+  shared_ptr<istream> p_src_;
+  unique_ptr<decoder> p_dec_;
+  vector<char> in_buf_;
+  vector<char> out_buf_;
+  const char * in_pos_;
+  const char * in_end_;
+  bool src_done_;
+  bool finished_;
+};
+
+void decode_istreambuf::refill()
+{
+  istream & src = *p_src_;
+  streamsize n = src.readsome(in_buf_.data(), in_buf_.size());
+  if (n == 0 && src.good() && src.peek() != EOF) {
+    n = src.readsome(in_buf_.data(), in_buf_.size());
+  }
+  in_pos_ = in_buf_.data();
+  in_end_ = in_pos_ + n;
+  src_done_ = (n == 0);
+}
+
+//! Decode at least one byte directly into s unless input is finished
+streamsize decode_istreambuf::produce(char * s, streamsize n)
+{
+  char * out = s;
+  while (out == s && !finished_) {
+    if (in_pos_ == in_end_ && !src_done_) {
+      refill();
+    }
+    const char * prev_in = in_pos_;
+    if (!p_dec_->decode(in_pos_, in_end_, out, s + n)) {
+      BOOST_THROW_EXCEPTION(runtime_error("corrupt compressed input"));
+    }
+    if (out == s && in_pos_ == prev_in) {
+      if (in_pos_ != in_end_) {
+        BOOST_THROW_EXCEPTION(runtime_error("corrupt compressed input"));
+      }
+      if (src_done_) {
+        if (!p_dec_->at_boundary()) {
+          BOOST_THROW_EXCEPTION(runtime_error("truncated compressed input"));
+        }
+        finished_ = true;
+      }
+    }
+  }
+  return out - s;
+}
+
+decode_istreambuf::int_type decode_istreambuf::underflow()
+{
+  if (gptr() == egptr()) {
+    streamsize n = produce(out_buf_.data(), out_buf_.size());
+    setg(out_buf_.data(), out_buf_.data(), out_buf_.data() + n);
+  }
+  if (gptr() == egptr()) return traits_type::eof();
+  return traits_type::to_int_type(*gptr());
+}
+
+streamsize decode_istreambuf::xsgetn(char * s, streamsize n)
+{
+  streamsize ret = min<streamsize>(n, egptr() - gptr());
+  copy(gptr(), gptr() + ret, s);
+  gbump(ret);
+  while (ret < n) {
+    streamsize got = produce(s + ret, n - ret);
+    if (!got) break;
+    ret += got;
+  }
+  return ret;
+}
+
+streamsize decode_istreambuf::showmanyc()
+{
+  return (finished_ ? -1 : streamsize(out_buf_.size()));
+}
+
+// encoder
+
+class encoder
+{
+public:
+  virtual ~encoder() {}
+
+  //! Encode input at in into output at out, advancing both.
+  //! If end, finish the compressed stream and return true once done.
+  virtual bool encode(const char * & in, const char * in_end,
+                      char * & out, char * out_end, bool end) = 0;
+};
+
+class gzip_encoder : public encoder
+{
+public:
+  gzip_encoder()
+  {
+    memset(&z_, 0, sizeof(z_));
+    // adding 16 to window bits writes gzip header and trailer
+    if (deflateInit2(&z_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      BOOST_THROW_EXCEPTION(bad_alloc());
+    }
+  }
+
+  ~gzip_encoder() override { deflateEnd(&z_); }
+
+  bool encode(const char * & in, const char * in_end,
+              char * & out, char * out_end, bool end) override
+  {
+    z_.next_in = (Bytef *)in;
+    z_.avail_in = clamp_uint(in_end - in);
+    z_.next_out = (Bytef *)out;
+    z_.avail_out = clamp_uint(out_end - out);
+    int rc = deflate(&z_, end ? Z_FINISH : Z_NO_FLUSH);
+    in = (const char *)z_.next_in;
+    out = (char *)z_.next_out;
+    if (rc == Z_STREAM_ERROR) {
+      BOOST_THROW_EXCEPTION(runtime_error("gzip compression failed"));
+    }
+    return rc == Z_STREAM_END;
+  }
+
+private:
+  z_stream z_;
+};
+
+#ifdef JIOS_WITH_ZSTD
+
+class zstd_encoder : public encoder
+{
+public:
+  zstd_encoder(unsigned threads)
+    : p_cctx_(ZSTD_createCCtx())
+  {
+    if (!p_cctx_) {
+      BOOST_THROW_EXCEPTION(bad_alloc());
+    }
+    if (threads > 1) {
+      // ignored unless libzstd is built with multithreading
+      ZSTD_CCtx_setParameter(p_cctx_, ZSTD_c_nbWorkers, threads);
+    }
+  }
+
+  ~zstd_encoder() override { ZSTD_freeCCtx(p_cctx_); }
+
+  bool encode(const char * & in, const char * in_end,
+              char * & out, char * out_end, bool end) override
+  {
+    ZSTD_inBuffer ib = { in, size_t(in_end - in), 0 };
+    ZSTD_outBuffer ob = { out, size_t(out_end - out), 0 };
+    size_t rc = ZSTD_compressStream2(p_cctx_, &ob, &ib,
+                                     end ? ZSTD_e_end : ZSTD_e_continue);
+    in += ib.pos;
+    out += ob.pos;
+    if (ZSTD_isError(rc)) {
+      BOOST_THROW_EXCEPTION(runtime_error("zstd compression failed"));
+    }
+    return end && rc == 0;
+  }
+
+private:
+  ZSTD_CCtx * const p_cctx_;
+};
+
+#endif
+
+// encode_ostreambuf
+
+//! Compresses straight out of its put area, which is the buffer
+//! written to by ostream users.
+
+class encode_ostreambuf : public streambuf
+{
+public:
+  encode_ostreambuf(ostream & dest, unique_ptr<encoder> && p_enc)
+    : dest_(dest)
+    , p_enc_(move(p_enc))
+    , in_buf_(compress_buffer_size)
+    , out_buf_(compress_buffer_size)
+    , finished_(false)
+  {
+    setp(in_buf_.data(), in_buf_.data() + in_buf_.size());
+  }
+
+  void finish();
+  ostream & target() { return dest_; }
+
+protected:
+  int_type overflow(int_type ch) override;
+
+private:
+  void drain(bool end);
+
+  ostream & dest_;
+  unique_ptr<encoder> p_enc_;
+  vector<char> in_buf_;
+  vector<char> out_buf_;
+  bool finished_;
+};
+
+void encode_ostreambuf::drain(bool end)
+{
+  const char * in = pbase();
+  const char * in_end = pptr();
+  bool done = false;
+  while (in != in_end || (end && !done)) {
+    char * out = out_buf_.data();
+    done = p_enc_->encode(in, in_end, out, out + out_buf_.size(), end);
+    dest_.write(out_buf_.data(), out - out_buf_.data());
+  }
+  setp(in_buf_.data(), in_buf_.data() + in_buf_.size());
+}
+
+encode_ostreambuf::int_type encode_ostreambuf::overflow(int_type ch)
+{
+  drain(false);
+  if (!dest_) return traits_type::eof();
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+void encode_ostreambuf::finish()
+{
+  if (!finished_) {
+    finished_ = true;
+    drain(true);
+    dest_.flush();
+  }
+}
+
+// worker_pool
+
+class worker_pool
+  : boost::noncopyable
+{
+public:
+  explicit worker_pool(unsigned threads);
+  ~worker_pool();
+
+  future<string> submit(function<string()> const& f);
+
+private:
+  void run();
+
+  mutex mutex_;
+  condition_variable cv_;
+  deque<function<void()>> tasks_;
+  bool stop_;
+  vector<thread> threads_;
+};
+
+worker_pool::worker_pool(unsigned threads)
+  : stop_(false)
+{
+  for (unsigned i = 0; i < threads; ++i) {
+    threads_.emplace_back([this]() { this->run(); });
+  }
+}
+
+worker_pool::~worker_pool()
+{
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (thread & t : threads_) { t.join(); }
+}
+
+future<string> worker_pool::submit(function<string()> const& f)
+{
+  auto p_task = make_shared<packaged_task<string()>>(f);
+  future<string> ret = p_task->get_future();
+  {
+    lock_guard<mutex> lock(mutex_);
+    tasks_.push_back([p_task]() { (*p_task)(); });
+  }
+  cv_.notify_one();
+  return ret;
+}
+
+void worker_pool::run()
+{
+  for (;;) {
+    function<void()> task;
+    {
+      unique_lock<mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+      if (tasks_.empty()) return;
+      task = move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+// parallel_gzip_ostreambuf
+
+string gzip_block(vector<char> const& block)
+{
+  z_stream z;
+  memset(&z, 0, sizeof(z));
+  if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    BOOST_THROW_EXCEPTION(bad_alloc());
+  }
+  string ret(deflateBound(&z, block.size()), '\0');
+  z.next_in = (Bytef *)block.data();
+  z.avail_in = block.size();
+  z.next_out = (Bytef *)&ret[0];
+  z.avail_out = ret.size();
+  int rc = deflate(&z, Z_FINISH);
+  ret.resize(z.total_out);
+  deflateEnd(&z);
+  if (rc != Z_STREAM_END) {
+    BOOST_THROW_EXCEPTION(runtime_error("gzip compression failed"));
+  }
+  return ret;
+}
+
+//! Hands each full put area to a worker pool to compress as a separate
+//! gzip member, writing compressed members in order.
+
+class parallel_gzip_ostreambuf : public streambuf
+{
+public:
+  parallel_gzip_ostreambuf(ostream & dest, unsigned threads)
+    : dest_(dest)
+    , pool_(threads)
+    , max_pending_(2 * threads)
+    , block_(parallel_block_size)
+    , finished_(false)
+  {
+    setp(block_.data(), block_.data() + block_.size());
+  }
+
+  void finish();
+  ostream & target() { return dest_; }
+
+protected:
+  int_type overflow(int_type ch) override;
+
+private:
+  void submit();
+  void write_front();
+
+  ostream & dest_;
+  worker_pool pool_;
+  size_t const max_pending_;
+  deque<future<string>> pending_;
+  vector<char> block_;
+  bool finished_;
+};
+
+void parallel_gzip_ostreambuf::write_front()
+{
+  string compressed = pending_.front().get();
+  pending_.pop_front();
+  dest_.write(compressed.data(), compressed.size());
+}
+
+void parallel_gzip_ostreambuf::submit()
+{
+  size_t n = pptr() - pbase();
+  if (n > 0) {
+    block_.resize(n);
+    auto p_block = make_shared<vector<char>>(move(block_));
+    pending_.push_back(pool_.submit([p_block]() {
+      return gzip_block(*p_block);
+    }));
+    block_ = vector<char>(parallel_block_size);
+    while (pending_.size() > max_pending_) {
+      write_front();
+    }
+  }
+  setp(block_.data(), block_.data() + block_.size());
+}
+
+parallel_gzip_ostreambuf::int_type
+    parallel_gzip_ostreambuf::overflow(int_type ch)
+{
+  submit();
+  if (!dest_) return traits_type::eof();
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+  return traits_type::not_eof(ch);
+}
+
+void parallel_gzip_ostreambuf::finish()
+{
+  if (!finished_) {
+    finished_ = true;
+    submit();
+    while (!pending_.empty()) {
+      write_front();
+    }
+    dest_.flush();
+  }
+}
+
+// streams owning their stream buffer
+
+template<class Buf>
+class owning_istream : public istream
+{
+public:
+  template<class... Args>
+  owning_istream(Args &&... args)
+    : istream(nullptr)
+    , buf_(forward<Args>(args)...)
+  {
+    this->rdbuf(&buf_);
+  }
+
+private:
+  Buf buf_;
+};
+
+//! ostream returned by compressed_ostream
+
+class compressing_ostream : public ostream
+{
+public:
+  //! Complete the compressed output. Failures set badbit on this stream
+  //! and on the target.
+  virtual void finish() = 0;
+
+protected:
+  compressing_ostream() : ostream(nullptr) {}
+};
+
+template<class Buf>
+class owning_ostream : public compressing_ostream
+{
+public:
+  template<class... Args>
+  owning_ostream(Args &&... args)
+    : buf_(forward<Args>(args)...)
+    , finished_(false)
+  {
+    this->rdbuf(&buf_);
+  }
+
+  ~owning_ostream()
+  {
+    // fallback if not finished, leaving failures visible on the target
+    try {
+      this->finish();
+    } catch (...) {
+    }
+  }
+
+  void finish() override
+  {
+    if (finished_) return;
+    finished_ = true;
+    bool ok = this->good();
+    try {
+      buf_.finish();
+    } catch (...) {
+      ok = false;
+    }
+    if (!ok || !buf_.target()) {
+      buf_.target().setstate(ios_base::badbit);
+      this->setstate(ios_base::badbit);
+    }
+  }
+
+private:
+  Buf buf_;
+  bool finished_;
+};
+
+} // namespace
+
+// factory functions
+
+bool compression_supported(compression c)
+{
+  switch (c) {
+    case compression::gzip:
+      return true;
+    case compression::zstd:
+#ifdef JIOS_WITH_ZSTD
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+shared_ptr<istream> decompressed_istream(shared_ptr<istream> const& p_is)
+{
+  if (!p_is) {
+    BOOST_THROW_EXCEPTION(bad_alloc());
+  }
+  unique_ptr<decoder> p_dec;
+  switch (p_is->peek()) {
+    case 0x1f:
+      p_dec.reset(new gzip_decoder());
+      break;
+#ifdef JIOS_WITH_ZSTD
+    case 0x28:
+      p_dec.reset(new zstd_decoder());
+      break;
+#endif
+    default:
+      return p_is;
+  }
+  typedef owning_istream<decode_istreambuf> stream_type;
+  return make_shared<stream_type>(p_is, move(p_dec));
+}
+
+shared_ptr<istream> decompressed_istream(istream & is)
+{
+  return decompressed_istream(shared_ptr<istream>(&is, boost::null_deleter()));
+}
+
+shared_ptr<ostream> compressed_ostream(ostream & os,
+                                       compression c,
+                                       unsigned threads)
+{
+  unique_ptr<encoder> p_enc;
+  switch (c) {
+    case compression::gzip:
+      if (threads > 1) {
+        typedef owning_ostream<parallel_gzip_ostreambuf> stream_type;
+        return make_shared<stream_type>(os, threads);
+      }
+      p_enc.reset(new gzip_encoder());
+      break;
+    case compression::zstd:
+#ifdef JIOS_WITH_ZSTD
+      p_enc.reset(new zstd_encoder(threads));
+#endif
+      break;
+  }
+  if (!p_enc) {
+    BOOST_THROW_EXCEPTION(invalid_argument("compression not supported"));
+  }
+  typedef owning_ostream<encode_ostreambuf> stream_type;
+  return make_shared<stream_type>(os, move(p_enc));
+}
+
+void finish_compressed(ostream & os)
+{
+  compressing_ostream * p_os = dynamic_cast<compressing_ostream *>(&os);
+  if (!p_os) {
+    BOOST_THROW_EXCEPTION(invalid_argument("not a compressed_ostream"));
+  }
+  p_os->finish();
+}
+
+ijstream compressed_json_in(shared_ptr<istream> const& p_is)
+{
+  return json_in(decompressed_istream(p_is));
+}
+
+ijstream compressed_json_in(istream & is)
+{
+  return json_in(decompressed_istream(is));
+}
+
+ojstream compressed_lined_json_out(ostream & os,
+                                   compression c,
+                                   unsigned threads)
+{
+  return lined_json_out(compressed_ostream(os, c, threads), '\n');
+}
+
+
+} // namespace
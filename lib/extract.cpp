@@ -0,0 +1,163 @@
+
+#include <jios/extract.hpp>
+
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <boost/throw_exception.hpp>
+#include <jios/tape.hpp>
+
+using namespace std;
+
+namespace jios {
+
+
+struct path_extractor::node
+{
+  unordered_map<string, unique_ptr<node>> children;
+  unique_ptr<node> any;
+  vector<callback> actions;
+
+  //! Add the children matching key to dest
+  void find(string const& key, vector<node const*> & dest) const
+  {
+    auto it = children.find(key);
+    if (it != children.end()) { dest.push_back(it->second.get()); }
+    if (any) { dest.push_back(any.get()); }
+  }
+
+  bool wants_members() const { return any || !children.empty(); }
+};
+
+namespace {
+
+//! Split JSON Pointer into unescaped reference tokens
+vector<string> parse_pointer(string const& pointer)
+{
+  vector<string> ret;
+  if (pointer.empty()) return ret;
+  if (pointer[0] != '/') {
+    BOOST_THROW_EXCEPTION(invalid_argument("invalid JSON Pointer"));
+  }
+  for (size_t i = 0; i < pointer.size(); ++i) {
+    char ch = pointer[i];
+    if (ch == '/') {
+      ret.emplace_back();
+    } else if (ch == '~') {
+      char next = (i + 1 < pointer.size() ? pointer[++i] : '\0');
+      if (next == '0') { ret.back() += '~'; }
+      else if (next == '1') { ret.back() += '/'; }
+      else {
+        BOOST_THROW_EXCEPTION(invalid_argument("invalid JSON Pointer"));
+      }
+    } else {
+      ret.back() += ch;
+    }
+  }
+  return ret;
+}
+
+typedef vector<path_extractor::node const*> node_set;
+
+void visit(ijvalue & ij, node_set const& active);
+
+//! Visit the members or elements of ij with the children of active
+void descend(ijvalue & ij, node_set const& active)
+{
+  node_set next;
+  switch (ij.type()) {
+    case json_type::jobject:
+      {
+        ijobject ijo = ij.object();
+        while (!ijo.at_end()) {
+          next.clear();
+          string const key = ijo.key();
+          for (auto p : active) { p->find(key, next); }
+          if (next.empty()) { ijo.skip(); }
+          else { visit(ijo.get(), next); }
+        }
+      }
+      break;
+    case json_type::jarray:
+      {
+        bool indexed = false;
+        for (auto p : active) { indexed |= !p->children.empty(); }
+        ijarray ija = ij.array();
+        for (size_t i = 0; !ija.at_end(); ++i) {
+          next.clear();
+          if (indexed) {
+            string const key = to_string(i);
+            for (auto p : active) { p->find(key, next); }
+          } else {
+            for (auto p : active) {
+              if (p->any) { next.push_back(p->any.get()); }
+            }
+          }
+          if (next.empty()) { ija.skip(); }
+          else { visit(ija.get(), next); }
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+//! Run the actions of all active nodes on ij and descend into it for
+//! their children. A value read more than once is first put on a tape.
+void visit(ijvalue & ij, node_set const& active)
+{
+  size_t reads = 0;
+  bool members = false;
+  for (auto p : active) {
+    reads += p->actions.size();
+    members |= p->wants_members();
+  }
+  if (members) { ++reads; }
+  if (reads <= 1) {
+    for (auto p : active) {
+      for (auto const& f : p->actions) { f(ij); }
+    }
+    if (members) { descend(ij, active); }
+    return;
+  }
+  tape t;
+  jios_read(ij, t);
+  for (auto p : active) {
+    for (auto const& f : p->actions) {
+      ijstream copy = tape_in(t);
+      f(copy.get());
+    }
+  }
+  if (members) {
+    ijstream copy = tape_in(t);
+    descend(copy.get(), active);
+  }
+}
+
+} // namespace
+
+path_extractor::path_extractor()
+  : root_(make_shared<node>())
+{}
+
+path_extractor & path_extractor::bind(string const& pointer,
+                                      callback const& f)
+{
+  node * p = root_.get();
+  for (string const& token : parse_pointer(pointer)) {
+    unique_ptr<node> & sub = (token == "*" ? p->any : p->children[token]);
+    if (!sub) { sub.reset(new node()); }
+    p = sub.get();
+  }
+  p->actions.push_back(f);
+  return *this;
+}
+
+void path_extractor::extract(ijvalue & src) const
+{
+  visit(src, node_set(1, root_.get()));
+}
+
+
+} // namespace
@@ -1,7 +1,9 @@
 #include <jios/istream_ij.hpp>
 
+#include <cstdlib>
 #include <boost/throw_exception.hpp>
 #include <boost/core/null_deleter.hpp>
+#include <jios/trace.hpp>
 
 using namespace std;
 
@@ -71,6 +73,175 @@ void istream_facade::remove_until(const char * it)
   remove(it - buf_.data());
 }
 
+// value_scanner
+
+inline bool is_ws(char ch)
+{
+  return ::isspace((unsigned char)ch);
+}
+
+const char * value_scanner::scan(const char * it, const char * end)
+{
+  for (; it != end; ++it) {
+    char ch = *it;
+    switch (state_) {
+      case scan_state::start:
+        if (is_ws(ch)) break;
+        switch (ch) {
+          case '{': case '[':
+            depth_ = 1;
+            state_ = scan_state::nested;
+            break;
+          case '"':
+            state_ = scan_state::string;
+            break;
+          case ',': case ':': case ']': case '}':
+            state_ = scan_state::error;
+            return it;
+          default:
+            state_ = scan_state::literal;
+        }
+        break;
+      case scan_state::literal:
+        if (is_ws(ch) || ch == ',' || ch == ']' || ch == '}') {
+          state_ = scan_state::done;
+          return it;
+        }
+        break;
+      case scan_state::string:
+        if (ch == '\\') {
+          state_ = scan_state::string_escape;
+        } else if (ch == '"') {
+          state_ = scan_state::done;
+          return it + 1;
+        }
+        break;
+      case scan_state::string_escape:
+        state_ = scan_state::string;
+        break;
+      case scan_state::nested:
+        switch (ch) {
+          case '"':
+            state_ = scan_state::nested_string;
+            break;
+          case '{': case '[':
+            ++depth_;
+            break;
+          case '}': case ']':
+            if (--depth_ == 0) {
+              state_ = scan_state::done;
+              return it + 1;
+            }
+            break;
+        }
+        break;
+      case scan_state::nested_string:
+        if (ch == '\\') {
+          state_ = scan_state::nested_escape;
+        } else if (ch == '"') {
+          state_ = scan_state::nested;
+        }
+        break;
+      case scan_state::nested_escape:
+        state_ = scan_state::nested_string;
+        break;
+      case scan_state::done:
+      case scan_state::error:
+        return it;
+    }
+  }
+  return it;
+}
+
+void value_scanner::finish()
+{
+  if (state_ == scan_state::literal) {
+    state_ = scan_state::done;
+  } else if (state_ != scan_state::done) {
+    state_ = scan_state::error;
+  }
+}
+
+void skip_value(istream_facade & is)
+{
+  value_scanner scanner;
+  while (!scanner.done() && !scanner.failed() && !is.fail()) {
+    if (is.avail() > 0) {
+      const char * it = is.begin();
+      is.remove_until(scanner.scan(it, it + is.avail()));
+    } else if (is.eof()) {
+      scanner.finish();
+    } else {
+      detail::trace_scope trace(trace_event::io_wait);
+      is.peek();
+    }
+  }
+  if (scanner.failed()) {
+    is.set_failbit();
+  }
+}
+
+// number scanning
+
+inline bool is_delim(char ch)
+{
+  return is_ws(ch) || ch == ',' || ch == ']';
+}
+
+inline bool is_digit(char ch)
+{
+  return ch >= '0' && ch <= '9';
+}
+
+const char * scan_json_number(const char * it, const char * end)
+{
+  const char * p = it;
+  if (p != end && *p == '-') ++p;
+  if (p == end || !is_digit(*p)) return nullptr;
+  if (*p++ != '0') {
+    while (p != end && is_digit(*p)) ++p;
+  }
+  if (p != end && *p == '.') {
+    if (++p == end || !is_digit(*p)) return nullptr;
+    while (p != end && is_digit(*p)) ++p;
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    if (p != end && (*p == '+' || *p == '-')) ++p;
+    if (p == end || !is_digit(*p)) return nullptr;
+    while (p != end && is_digit(*p)) ++p;
+  }
+  return p;
+}
+
+//! Parse a plain JSON number starting at it and followed by a delimiter
+//! before end. Return pointer past the number or null if not handled.
+const char * scan_number(const char * it, const char * end, int64_t & dest)
+{
+  const char * p = it;
+  if (p != end && *p == '-') ++p;
+  const char * digits = p;
+  uint64_t v = 0;
+  for (; p != end && is_digit(*p); ++p) {
+    v = v * 10 + (*p - '0');
+  }
+  size_t len = p - digits;
+  // at most 18 digits cannot overflow
+  if (len == 0 || len > 18 || (len > 1 && *digits == '0')) return nullptr;
+  if (p == end || !is_delim(*p)) return nullptr;
+  dest = (digits != it ? -int64_t(v) : int64_t(v));
+  return p;
+}
+
+const char * scan_number(const char * it, const char * end, double & dest)
+{
+  const char * p = scan_json_number(it, end);
+  if (!p || p == end || !is_delim(*p)) return nullptr;
+  char * num_end = nullptr;
+  dest = strtod(it, &num_end);
+  return (num_end == p ? p : nullptr);
+}
+
 // istream_ijsource
 
 class istream_ijsource : public ijsource
@@ -108,6 +279,7 @@ protected:
 void istream_ijsource::induce()
 {
   while (this->expecting()) {
+    detail::trace_scope trace(trace_event::io_wait);
     p_is_->peek();
   }
 }
@@ -143,7 +315,10 @@ void istream_stream_ijsource::do_advance()
 
 bool istream_stream_ijsource::do_expecting()
 {
-  p_parser_->parse(p_is_);
+  {
+    detail::trace_scope trace(trace_event::parse);
+    p_parser_->parse(p_is_);
+  }
   return !p_parser_->is_parsed() && p_is_->good();
 }
 
@@ -165,12 +340,16 @@ class istream_array_ijsource : public istream_ijsource
 {
 public:
   istream_array_ijsource(shared_ptr<istream_facade> const& p_is,
-                         shared_ptr<istream_parser> const& p_p)
+                         shared_ptr<istream_parser> const& p_p,
+                         bool begun = false)
     : istream_ijsource(p_is, p_p)
-    , state_(parse_state::start)
+    , state_(begun ? parse_state::poststart : parse_state::start)
     , multiline_(false)
+    , parsing_(false)
   {}
 
+  //! Advance until reaching terminator, if no failure.
+  void finish();
 
 private:
   bool do_is_terminator() override;
@@ -178,8 +357,15 @@ private:
   bool do_expecting() override;
   bool do_hint_multiline() const override { return multiline_; }
   void do_restart() override;
+  size_t do_read_numbers(int64_t * dest, size_t n) override;
+  size_t do_read_numbers(double * dest, size_t n) override;
+
+  template<typename T>
+  size_t scan_numbers(T * dest, size_t n);
 
   bool parse_char();
+  void scan_delims();
+  void induce_delims();
 
   enum class parse_state {
     start,
@@ -191,20 +377,27 @@ private:
 
   parse_state state_;
   bool multiline_;
+  bool parsing_; // whether value parsing has started
 };
 
 bool istream_array_ijsource::do_is_terminator()
 {
-  induce();
+  induce_delims();
   return state_ == parse_state::finish || this->fail();
 }
 
 void istream_array_ijsource::do_advance()
 {
-  induce();
+  induce_delims();
   BOOST_ASSERT(state_ != parse_state::finish);
   BOOST_ASSERT(state_ == parse_state::value || this->fail());
+  if (parsing_) {
+    induce();
+  } else if (state_ == parse_state::value) {
+    skip_value(*p_is_);
+  }
   p_parser_->clear();
+  parsing_ = false;
   if (state_ == parse_state::value) {
     state_ = parse_state::predelim;
   }
@@ -255,7 +448,7 @@ bool istream_array_ijsource::parse_char()
   return false;
 }
 
-bool istream_array_ijsource::do_expecting()
+void istream_array_ijsource::scan_delims()
 {
   while (p_is_->avail() && parse_char()) {
     p_is_->remove(1);
@@ -263,9 +456,32 @@ bool istream_array_ijsource::do_expecting()
   if (p_is_->eof()) {
     this->set_failbit();
   }
+}
+
+//! Like induce, but stop before parsing any value
+void istream_array_ijsource::induce_delims()
+{
+  scan_delims();
+  while (state_ != parse_state::value && state_ != parse_state::finish
+         && p_is_->good()) {
+    {
+      detail::trace_scope trace(trace_event::io_wait);
+      p_is_->peek();
+    }
+    scan_delims();
+  }
+}
+
+bool istream_array_ijsource::do_expecting()
+{
+  scan_delims();
   switch (state_) {
     case parse_state::value:
-      p_parser_->parse(p_is_);
+      parsing_ = true;
+      {
+        detail::trace_scope trace(trace_event::parse);
+        p_parser_->parse(p_is_);
+      }
       return !p_parser_->is_parsed() && p_is_->good();
     case parse_state::finish:
       return false;
@@ -275,18 +491,66 @@ bool istream_array_ijsource::do_expecting()
   return p_is_->good();
 }
 
+//! Scan numbers directly from the input buffer, falling back to
+//! parsing an element when it is not a plain number fully buffered.
+template<typename T>
+size_t istream_array_ijsource::scan_numbers(T * dest, size_t n)
+{
+  size_t count = 0;
+  while (count < n) {
+    induce_delims();
+    if (state_ != parse_state::value || this->fail()) break;
+    const char * stop = nullptr;
+    if (!parsing_) {
+      const char * it = p_is_->begin();
+      stop = scan_number(it, it + p_is_->avail(), dest[count]);
+    }
+    if (stop) {
+      p_is_->remove_until(stop);
+      state_ = parse_state::predelim;
+    } else if (!this->read_next(dest[count])) {
+      break;
+    }
+    ++count;
+  }
+  return count;
+}
+
+size_t istream_array_ijsource::do_read_numbers(int64_t * dest, size_t n)
+{
+  return scan_numbers(dest, n);
+}
+
+size_t istream_array_ijsource::do_read_numbers(double * dest, size_t n)
+{
+  return scan_numbers(dest, n);
+}
+
+void istream_array_ijsource::finish()
+{
+  while (!this->is_terminator() && !this->fail()) {
+    this->advance();
+  }
+}
+
 void istream_array_ijsource::do_restart()
 {
   if (state_ != parse_state::start) {
-    while (!this->is_terminator() && !this->fail()) {
-      this->advance();
-    }
+    this->finish();
   }
   p_parser_->clear();
+  parsing_ = false;
   state_ = parse_state::start;
   multiline_ = false;
 }
 
+shared_ptr<ijsource>
+    make_array_tail_ijsource(shared_ptr<istream_facade> const& p_is,
+                             shared_ptr<istream_parser> const& p_p)
+{
+  return make_shared<istream_array_ijsource>(p_is, p_p, true);
+}
+
 // streaming_parser
 
 class streaming_parser : public istream_parser, private ijpair
@@ -296,6 +560,7 @@ public:
                    istream_parser_factory const& fallback)
     : p_is_(p_is)
     , p_parser_(fallback(p_is))
+    , state_(value_state::idle)
   {
     if (!p_is_ || !p_parser_) {
       BOOST_THROW_EXCEPTION(bad_alloc());
@@ -305,7 +570,7 @@ public:
 private:
   // istream_parser virtual methods
   void do_clear() override;
-  void do_parse(std::shared_ptr<istream_facade> const& p_is) override {}
+  void do_parse(std::shared_ptr<istream_facade> const& p_is) override;
   bool do_is_parsed() const override { return true; }
   ijpair & do_result() { return *this; }
 
@@ -324,28 +589,68 @@ private:
   ijarray do_begin_array() override;
   ijobject do_begin_object() { failout(); return ijobject(); }
 
+  void do_skip() override;
+
   std::string do_key() const { BOOST_ASSERT(false); return ""; }
 
   void failout() { this->set_failbit(); }
 
+  enum class value_state {
+    idle,    // no array value parsed
+    pending, // array value parsed but not begun
+    begun,   // array value begun with p_src_
+    done     // array value consumed from input
+  };
+
   shared_ptr<istream_facade> p_is_;
   shared_ptr<istream_parser> p_parser_;
-  shared_ptr<istream_ijsource> p_src_;
+  shared_ptr<istream_array_ijsource> p_src_;
+  value_state state_;
 };
 
+void streaming_parser::do_parse(std::shared_ptr<istream_facade> const&)
+{
+  if (state_ == value_state::idle) {
+    state_ = value_state::pending;
+  }
+}
+
+void streaming_parser::do_skip()
+{
+  switch (state_) {
+    case value_state::pending:
+      skip_value(*p_is_);
+      break;
+    case value_state::begun:
+      p_src_->finish();
+      break;
+    default:
+      return;
+  }
+  state_ = value_state::done;
+}
+
 void streaming_parser::do_clear()
 {
-  p_src_->restart();
+  this->do_skip();
+  if (p_src_) {
+    p_src_->restart();
+  }
   p_parser_->clear();
+  state_ = value_state::idle;
 }
 
 ijarray streaming_parser::do_begin_array()
 {
-  if (p_src_) {
-    p_src_->restart();
-  } else {
+  BOOST_ASSERT(state_ != value_state::done);
+  if (state_ == value_state::done) {
+    failout();
+    return ijarray();
+  }
+  if (!p_src_) {
     p_src_.reset(new istream_array_ijsource(p_is_, p_parser_));
   }
+  state_ = value_state::begun;
   return ijarray(p_src_);
 }
 
@@ -1,6 +1,11 @@
 #include <jios/jin.hpp>
 
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <limits>
+#include <jios/trace.hpp>
 
 using namespace std;
 
@@ -56,11 +61,27 @@ void ijstreamoid::increment(ijstreamoid * & p_src)
 void ijstreamoid::unexpire()
 {
   if (expired_) {
-    pimpl_->advance();
+    // a failed read of the value ends the stream, leaving nothing to pass
+    if (!this->fail()) { pimpl_->advance(); }
     expired_ = false;
   }
 }
 
+void ijstreamoid::skip()
+{
+  unexpire();
+  BOOST_ASSERT(!pimpl_->is_terminator());
+  if (!pimpl_->is_terminator()) {
+    expired_ = true;
+  }
+}
+
+size_t ijstreamoid::size_hint()
+{
+  unexpire();
+  return pimpl_->size_hint();
+}
+
 bool ijstreamoid::expecting()
 {
   unexpire();
@@ -82,6 +103,12 @@ ijpair & ijstreamoid::extract()
   return ret;
 }
 
+ijsource & ijstreamoid::source()
+{
+  unexpire();
+  return *pimpl_;
+}
+
 ijpair & ijobject::get() &
 {
   return this->extract();
@@ -107,6 +134,12 @@ string ijpair::key() const
   return do_key();
 }
 
+boost::string_ref ijpair::do_key_ref() const
+{
+  key_buf_ = do_key();
+  return key_buf_;
+}
+
 ijarray ijvalue::array()
 {
   return do_begin_array();
@@ -122,6 +155,42 @@ json_type ijvalue::type() const
   return do_type();
 }
 
+boost::string_ref ijvalue::do_raw_number()
+{
+  char text[32];
+  int len = 0;
+  switch (do_type()) {
+    case json_type::jinteger:
+      {
+        int64_t i = 0;
+        do_parse(i);
+        len = snprintf(text, sizeof(text), "%" PRId64, i);
+      }
+      break;
+    case json_type::jfloat:
+      {
+        double d = 0;
+        do_parse(d);
+        // inf and nan are not JSON numbers
+        if (!std::isfinite(d)) {
+          set_failbit();
+          break;
+        }
+        len = snprintf(text, sizeof(text), "%.17g", d);
+        if (strcspn(text, ".en") == size_t(len)) {
+          len += snprintf(text + len, sizeof(text) - len, ".0");
+        }
+      }
+      break;
+    default:
+      set_failbit();
+      break;
+  }
+  if (fail()) return boost::string_ref();
+  number_buf_.assign(text, len);
+  return number_buf_;
+}
+
 istream & ijvalue::read_string_value()
 {
   buf_.clear();
@@ -166,6 +235,14 @@ void jios_read(ijvalue & ij, double & dest)
   ij.do_parse(dest);
 }
 
+void jios_read(ijvalue & ij, number_text & dest)
+{
+  boost::string_ref text = ij.raw_number();
+  if (!ij.fail()) {
+    dest.text.assign(text.begin(), text.end());
+  }
+}
+
 bool ijstreamoid::at_end()
 {
   unexpire();
@@ -217,23 +294,118 @@ void jios_read(ijvalue & ij, uint64_t & dest)
   }
 }
 
-void jios_read(ijvalue & ij, float & dest)
+template<typename T>
+bool narrow_number(int64_t src, T & dest)
+{
+  typedef numeric_limits<T> numeric;
+  if (src < numeric::min() || src > numeric::max()) return false;
+  dest = src;
+  return true;
+}
+
+bool narrow_number(double src, float & dest)
 {
   typedef numeric_limits<float> numeric;
+  if (isfinite(src)) {
+    if (src < numeric::lowest() || src > numeric::max()) return false;
+  }
+  dest = src;
+  return true;
+}
+
+void jios_read(ijvalue & ij, float & dest)
+{
   double tmp;
-  if (ij.read(tmp) && isfinite(tmp)) {
-    if (tmp < numeric::min() || tmp > numeric::max()) {
-      ij.set_failbit();
-    } 
+  if (ij.read(tmp) && !narrow_number(tmp, dest)) {
+    ij.set_failbit();
   }
-  if (!ij.fail()) {
-    dest = tmp;
+}
+
+// bulk numeric reads
+
+size_t ijarray::read_numbers(int64_t * dest, size_t n)
+{
+  return source().read_numbers(dest, n);
+}
+
+size_t ijarray::read_numbers(double * dest, size_t n)
+{
+  return source().read_numbers(dest, n);
+}
+
+//! Read via wide type in chunks, failing on values out of range
+template<typename Wide, typename T>
+size_t read_narrow_numbers(ijarray & ija, T * dest, size_t n)
+{
+  size_t const chunk_size = 256;
+  Wide chunk[chunk_size];
+  size_t count = 0;
+  while (count < n) {
+    size_t want = min(n - count, chunk_size);
+    size_t got = ija.read_numbers(chunk, want);
+    for (size_t i = 0; i < got; ++i) {
+      if (!narrow_number(chunk[i], dest[count])) {
+        ija.set_failbit();
+        return count;
+      }
+      ++count;
+    }
+    if (got < want) break;
   }
+  return count;
+}
+
+size_t ijarray::read_numbers(int32_t * dest, size_t n)
+{
+  return read_narrow_numbers<int64_t>(*this, dest, n);
+}
+
+size_t ijarray::read_numbers(float * dest, size_t n)
+{
+  return read_narrow_numbers<double>(*this, dest, n);
+}
+
+template<typename T>
+void read_number_vector(ijvalue & ij, vector<T> & dest)
+{
+  dest.clear();
+  ijarray ija = ij.array();
+  detail::append_numbers(ija, dest);
+}
+
+void jios_read(ijvalue & ij, vector<int64_t> & dest)
+{
+  read_number_vector(ij, dest);
+}
+
+void jios_read(ijvalue & ij, vector<int32_t> & dest)
+{
+  read_number_vector(ij, dest);
+}
+
+void jios_read(ijvalue & ij, vector<double> & dest)
+{
+  read_number_vector(ij, dest);
+}
+
+void jios_read(ijvalue & ij, vector<float> & dest)
+{
+  read_number_vector(ij, dest);
 }
 
 void jios_read(ijvalue & src, ojvalue & dest)
 {
-  switch (src.type()) {
+  json_type t = src.type();
+  bool structure = (json_type::jarray == t || json_type::jobject == t);
+  if (dest.accepts_raw_json(structure)) {
+    char const* p = nullptr;
+    size_t len = 0;
+    if (src.raw_json(p, len)) {
+      dest.write_raw_json(p, len);
+      return;
+    }
+  }
+  switch (t) {
     case json_type::jnull:
       dest.write_null();
       break;
@@ -359,6 +531,7 @@ void ijsource::advance()
   bool end = this->is_terminator();
   BOOST_ASSERT(!end);
   if (!end) {
+    detail::trace_scope trace(trace_event::advance);
     do_advance();
   }
 }
@@ -370,6 +543,39 @@ bool ijsource::expecting()
   return ret && !this->fail();
 }
 
+template<typename T>
+bool read_next_number(ijsource & src, T & dest)
+{
+  if (src.is_terminator()) return false;
+  if (!src.dereference().read(dest)) return false;
+  src.advance();
+  return true;
+}
+
+bool ijsource::read_next(int64_t & dest)
+{
+  return read_next_number(*this, dest);
+}
+
+bool ijsource::read_next(double & dest)
+{
+  return read_next_number(*this, dest);
+}
+
+size_t ijsource::do_read_numbers(int64_t * dest, size_t n)
+{
+  size_t count = 0;
+  while (count < n && read_next(dest[count])) { ++count; }
+  return count;
+}
+
+size_t ijsource::do_read_numbers(double * dest, size_t n)
+{
+  size_t count = 0;
+  while (count < n && read_next(dest[count])) { ++count; }
+  return count;
+}
+
 
 } // namespace
 
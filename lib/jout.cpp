@@ -1,5 +1,10 @@
 #include <jios/jout.hpp>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <jios/istream_ij.hpp>
+
 using namespace std;
 
 namespace jios {
@@ -20,6 +25,34 @@ bool ojstreamoid::at_end() const
   return !pimpl_ || pimpl_->do_is_terminator();
 }
 
+bool ojstreamoid::fail() const
+{
+  return pimpl_ && pimpl_->do_fail();
+}
+
+void jios_write(ojvalue & oj, number_text const& src)
+{
+  string const& text = src.text;
+  char const* end = text.data() + text.size();
+  if (scan_json_number(text.data(), end) != end) {
+    oj.set_failbit();
+    return;
+  }
+  if (oj.accepts_raw_json(false)) {
+    oj.write_raw_json(text.data(), text.size());
+    return;
+  }
+  if (text.find_first_of(".eE") == string::npos) {
+    errno = 0;
+    long long i = strtoll(text.c_str(), nullptr, 10);
+    if (errno == 0) {
+      oj.write_int(i);
+      return;
+    }
+  }
+  oj.write_double(strtod(text.c_str(), nullptr));
+}
+
 void ojvalue::write_string_value()
 {
   istreambuf_iterator<char> it(buf_);
@@ -29,6 +62,51 @@ void ojvalue::write_string_value()
   buf_.str(string());
 }
 
+void ojsink::do_print_numbers(int64_t const* src, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) { do_print(src[i]); }
+}
+
+void ojsink::do_print_numbers(double const* src, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) { do_print(src[i]); }
+}
+
+void ojarray::write_numbers(int64_t const* src, size_t n)
+{
+  if (pimpl_) { pimpl_->do_print_numbers(src, n); }
+}
+
+void ojarray::write_numbers(double const* src, size_t n)
+{
+  if (pimpl_) { pimpl_->do_print_numbers(src, n); }
+}
+
+//! Write via wide type in chunks
+template<typename Wide, typename T>
+void write_wide_numbers(ojarray & oja, T const* src, size_t n)
+{
+  size_t const chunk_size = 256;
+  Wide chunk[chunk_size];
+  while (n > 0) {
+    size_t count = min(n, chunk_size);
+    copy(src, src + count, chunk);
+    oja.write_numbers(chunk, count);
+    src += count;
+    n -= count;
+  }
+}
+
+void ojarray::write_numbers(int32_t const* src, size_t n)
+{
+  write_wide_numbers<int64_t>(*this, src, n);
+}
+
+void ojarray::write_numbers(float const* src, size_t n)
+{
+  write_wide_numbers<double>(*this, src, n);
+}
+
 void ojsink::set_key_with_string_value()
 {
   istreambuf_iterator<char> it(buf_);
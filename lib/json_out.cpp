@@ -1,8 +1,10 @@
 #include <jios/json_out.hpp>
 
+#include <cstdio>
 #include <boost/core/null_deleter.hpp>
 #include <boost/optional.hpp>
 #include <boost/type_traits/make_unsigned.hpp>
+#include <jios/trace.hpp>
 
 using namespace std;
 
@@ -86,6 +88,13 @@ protected:
   void do_print(double value) override { do_print_impl(value); }
   void do_print(bool value) override { do_print_impl(value); }
   void do_print(string_iterator it, string_iterator end);
+  void do_print_numbers(int64_t const* src, size_t n) override;
+  void do_print_numbers(double const* src, size_t n) override;
+
+  template<typename T> void do_print_numbers_impl(T const* src, size_t n);
+
+  bool do_accepts_raw_json(bool) const override { return true; }
+  void do_print_raw_json(char const* p, size_t len) override;
 
   virtual ojarray do_begin_array(bool multimode);
   virtual ojobject do_begin_object(bool multimode);
@@ -96,10 +105,14 @@ protected:
   void do_close();
   virtual void do_terminate();
   virtual bool do_is_terminator() const;
+  bool do_fail() const override { return os_->fail(); }
+  void do_set_failbit() override { os_->setstate(std::ios_base::failbit); }
 
 private:
   void init(bool object);
   virtual void post_comma_whitespace() {}
+  //! Text of post_comma_whitespace, for batched output
+  virtual std::string comma_whitespace() const { return std::string(); }
   virtual shared_ptr<ojsink> make_sub_struct(shared_ptr<ostream> const& os,
                                              bool in_object,
                                              bool multimode);
@@ -130,9 +143,11 @@ class pretty_ojnode
 public:
   virtual ~pretty_ojnode() {}
 
-  pretty_ojnode(shared_ptr<ostream> const& os, char delim)
+  pretty_ojnode(shared_ptr<ostream> const& os, char delim,
+                string const& unit = "\t")
     : ostream_ojnode(os, delim)
     , indent_(0)
+    , unit_(unit)
   {
   }
 
@@ -142,14 +157,22 @@ private:
        shared_ptr<ostream_ojnode> const& parent,
        bool in_object,
        bool multimode,
-       size_t indent)
+       size_t indent,
+       string const& unit)
     : ostream_ojnode(os, parent, in_object, multimode)
     , indent_(indent)
+    , unit_(unit)
   {
     newline();
   }
 
   virtual void post_comma_whitespace();
+  std::string comma_whitespace() const override;
+  //! Raw text of arrays and objects would not be indented
+  bool do_accepts_raw_json(bool structure) const override
+  {
+    return !structure;
+  }
   virtual shared_ptr<ojsink> make_sub_struct(shared_ptr<ostream> const& os,
                                              bool in_object,
                                              bool multimode);
@@ -158,6 +181,7 @@ private:
   void newline();
 
   size_t indent_;
+  string const unit_; // whitespace per indent level
 };
 
 template<typename T>
@@ -173,6 +197,7 @@ void json_print(std::ostream & os, bool const& value)
 
 void ostream_ojnode::do_print_null()
 {
+  detail::trace_scope trace(trace_event::write);
   if (CLEARED == state_) {
     out_prefix();
     *os_ << "null";
@@ -182,9 +207,22 @@ void ostream_ojnode::do_print_null()
   }
 }
 
+void ostream_ojnode::do_print_raw_json(char const* p, size_t len)
+{
+  detail::trace_scope trace(trace_event::write);
+  if (CLEARED == state_) {
+    out_prefix();
+    os_->write(p, len);
+    out_suffix();
+  } else {
+    os_->setstate(std::ios_base::failbit);
+  }
+}
+
 template<typename T>
 void ostream_ojnode::do_print_impl(T const& value)
 {
+  detail::trace_scope trace(trace_event::write);
   if (CLEARED == state_) {
     out_prefix();
     json_print(*os_, value);
@@ -194,8 +232,85 @@ void ostream_ojnode::do_print_impl(T const& value)
   }
 }
 
+//! Whether numbers format the same as with default ostream formatting
+bool default_number_format(ostream const& os)
+{
+  ios_base::fmtflags const special = ios_base::floatfield | ios_base::showpos
+                                   | ios_base::showpoint | ios_base::uppercase
+                                   | ios_base::showbase | ios_base::oct
+                                   | ios_base::hex;
+  return !(os.flags() & special) && os.width() == 0
+         && os.precision() <= 40 && os.getloc() == locale::classic();
+}
+
+size_t const max_number_chars = 64;
+
+size_t format_number(char * dest, int64_t value, int)
+{
+  char tmp[24];
+  char * const end = tmp + sizeof(tmp);
+  char * it = end;
+  uint64_t u = (value < 0 ? 0 - uint64_t(value) : uint64_t(value));
+  do {
+    *--it = char('0' + u % 10);
+    u /= 10;
+  } while (u);
+  if (value < 0) { *--it = '-'; }
+  copy(it, end, dest);
+  return end - it;
+}
+
+size_t format_number(char * dest, double value, int precision)
+{
+  return snprintf(dest, max_number_chars, "%.*g", precision, value);
+}
+
+//! Format array elements in batches directly into the output stream
+template<typename T>
+void ostream_ojnode::do_print_numbers_impl(T const* src, size_t n)
+{
+  string const sep = ',' + this->comma_whitespace();
+  if (o_delim_ || sep.size() > 1024 || !default_number_format(*os_)) {
+    ojsink::do_print_numbers(src, n);
+    return;
+  }
+  if (n == 0) return;
+  detail::trace_scope trace(trace_event::write);
+  if (CLEARED != state_) {
+    os_->setstate(std::ios_base::failbit);
+    return;
+  }
+  out_prefix();
+  int precision = os_->precision();
+  char buf[4096];
+  size_t len = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (len + sep.size() + max_number_chars > sizeof(buf)) {
+      os_->write(buf, len);
+      len = 0;
+    }
+    if (i > 0) {
+      copy(sep.begin(), sep.end(), buf + len);
+      len += sep.size();
+    }
+    len += format_number(buf + len, src[i], precision);
+  }
+  os_->write(buf, len);
+}
+
+void ostream_ojnode::do_print_numbers(int64_t const* src, size_t n)
+{
+  do_print_numbers_impl(src, n);
+}
+
+void ostream_ojnode::do_print_numbers(double const* src, size_t n)
+{
+  do_print_numbers_impl(src, n);
+}
+
 void ostream_ojnode::do_print(string_iterator it, string_iterator end)
 {
+  detail::trace_scope trace(trace_event::write);
   if (CLEARED == state_) {
     out_prefix();
     *os_ << '"';
@@ -249,6 +364,7 @@ void ostream_ojnode::do_set_key(string_iterator it, string_iterator end)
 
 void ostream_ojnode::do_flush()
 {
+  detail::trace_scope trace(trace_event::flush);
   os_->flush();
 }
 
@@ -321,6 +437,7 @@ void ostream_ojnode::out_suffix()
         *os_ << '\n';
       }
     }
+    detail::trace_scope trace(trace_event::flush);
     *os_ << std::flush;
   }
 }
@@ -334,7 +451,8 @@ shared_ptr<ojsink>
 {
   size_t sub_indent = indent_ + (multimode ? 1 : 0);
   shared_ptr<ostream_ojnode> sp = shared_from_this();
-  auto p = new pretty_ojnode(os_, sp, in_object, multimode, sub_indent);
+  auto p = new pretty_ojnode(os_, sp, in_object, multimode, sub_indent,
+                             unit_);
   return shared_ptr<pretty_ojnode>(p);
 }
 
@@ -350,11 +468,19 @@ void pretty_ojnode::post_comma_whitespace()
   else { newline(); }
 }
 
+std::string pretty_ojnode::comma_whitespace() const
+{
+  if (!multimode_) return " ";
+  string ret(1, '\n');
+  for (size_t i=0; i < indent_; ++i) { ret += unit_; }
+  return ret;
+}
+
 void pretty_ojnode::newline()
 {
   if (multimode_) {
     *os_ << '\n';
-    for (size_t i=0; i < indent_; ++i) { *os_ << '\t'; }
+    for (size_t i=0; i < indent_; ++i) { *os_ << unit_; }
   }
 }
 
@@ -371,6 +497,19 @@ ojstream json_out(shared_ptr<ostream> const& pos, char delim)
   return shared_ptr<ojsink>(new pretty_ojnode(pos, delim));
 }
 
+ojstream json_out(std::ostream & os, string const& indent, char delim)
+{
+  shared_ptr<ostream> sp(&os, boost::null_deleter());
+  return shared_ptr<ojsink>(new pretty_ojnode(sp, delim, indent));
+}
+
+ojstream json_out(shared_ptr<ostream> const& pos,
+                  string const& indent,
+                  char delim)
+{
+  return shared_ptr<ojsink>(new pretty_ojnode(pos, delim, indent));
+}
+
 ojstream lined_json_out(std::ostream & os)
 {
   shared_ptr<ostream> sp(&os, boost::null_deleter());
@@ -1,5 +1,6 @@
 #include <jios/jsonc_parser.hpp>
 
+#include <cmath>
 #include <json-c/json_tokener.h>
 #include <json-c/json_object.h>
 #include <json-c/linkhash.h>
@@ -16,6 +17,7 @@ public:
               json_object * p_node = NULL)
     : p_state_(p_state)
     , p_node_(json_object_get(p_node))
+    , present_(p_node != NULL)
   {}
 
   ~jsonc_value()
@@ -26,24 +28,33 @@ public:
     }
   }
 
+  //! Hold parsed value, where NULL is JSON null
   void reset_already_refcounted(json_object * p_new)
   {
     if (p_node_) {
       json_object_put(p_node_);
     }
     p_node_ = p_new;
+    present_ = true;
   }
 
-  void reset(json_object * p_new= NULL)
+  void reset(json_object * p_new)
   {
     reset_already_refcounted(json_object_get(p_new));
   }
 
+  //! Hold no value
+  void clear()
+  {
+    reset_already_refcounted(NULL);
+    present_ = false;
+  }
+
   void set_key(string const& key) { key_ = key; }
 
   json_object * jsonc_ptr() { return p_node_; }
 
-  bool is_empty() const { return !p_node_; }
+  bool is_empty() const { return !present_; }
 
 private:
   bool parse(const char * & begin, size_t & len) const;
@@ -62,13 +73,54 @@ private:
   ijarray do_begin_array() override;
   ijobject do_begin_object() override;
 
+  boost::string_ref do_raw_number() override
+  {
+    bool const is_double = json_object_is_type(p_node_, json_type_double);
+    if ((!is_double && !json_object_is_type(p_node_, json_type_int))
+        || (is_double && !std::isfinite(json_object_get_double(p_node_)))) {
+      set_failbit();
+      return boost::string_ref();
+    }
+    // json-c keeps the parsed text of doubles for serialization
+    size_t len = 0;
+    char const* p = json_object_to_json_string_length(
+        p_node_, JSON_C_TO_STRING_PLAIN, &len);
+    return boost::string_ref(p, len);
+  }
+
+  bool do_raw_json(char const* & p, size_t & len) override
+  {
+    int flags = JSON_C_TO_STRING_PLAIN | JSON_C_TO_STRING_NOSLASHESCAPE;
+    p = json_object_to_json_string_length(p_node_, flags, &len);
+    return p != NULL;
+  }
+
   string do_key() const override { return key_; }
+  boost::string_ref do_key_ref() const override { return key_; }
 
   shared_ptr<ijstate> p_state_;
   json_object * p_node_;
+  bool present_;
   string key_;
 };
 
+inline bool jsonc_number(json_object * p, int64_t & dest)
+{
+  if (!json_object_is_type(p, json_type_int)) return false;
+  dest = json_object_get_int64(p);
+  return true;
+}
+
+inline bool jsonc_number(json_object * p, double & dest)
+{
+  if (!json_object_is_type(p, json_type_double)
+      && !json_object_is_type(p, json_type_int)) {
+    return false;
+  }
+  dest = json_object_get_double(p);
+  return true;
+}
+
 class jsonc_parsed_ijsource: public ijsource
 {
 protected:
@@ -94,7 +146,7 @@ protected:
 
   bool do_is_terminator() override
   {
-    return value_.is_empty();
+    return value_.is_empty() || value_.fail();
   }
 
   bool do_expecting() override { return false; }
@@ -114,17 +166,60 @@ class jsonc_array_ijsource : public jsonc_parsed_ijsource
            && json_object_array_length(p_parent_) > 1;
   }
 
+  size_t do_size_hint() const override
+  {
+    if (!json_object_is_type(p_parent_, json_type_array)) return 0;
+    size_t length = json_object_array_length(p_parent_);
+    return (idx_ < length ? length - idx_ : 0);
+  }
+
   void do_advance() override
   {
     ++idx_;
     init();
   }
 
+  size_t do_read_numbers(int64_t * dest, size_t n) override
+  {
+    return read_jsonc_numbers(dest, n);
+  }
+
+  size_t do_read_numbers(double * dest, size_t n) override
+  {
+    return read_jsonc_numbers(dest, n);
+  }
+
+  template<typename T>
+  size_t read_jsonc_numbers(T * dest, size_t n)
+  {
+    if (!json_object_is_type(p_parent_, json_type_array)) {
+      value_.set_failbit();
+      return 0;
+    }
+    size_t length = json_object_array_length(p_parent_);
+    size_t count = 0;
+    while (count < n && idx_ < length) {
+      json_object * p = json_object_array_get_idx(p_parent_, idx_);
+      if (!jsonc_number(p, dest[count])) {
+        value_.set_failbit();
+        break;
+      }
+      ++idx_;
+      ++count;
+    }
+    init();
+    return count;
+  }
+
   void init()
   {
     BOOST_ASSERT(json_object_is_type(p_parent_, json_type_array));
     if (json_object_is_type(p_parent_, json_type_array)) {
-      value_.reset(json_object_array_get_idx(p_parent_, idx_));
+      if (idx_ < json_object_array_length(p_parent_)) {
+        value_.reset(json_object_array_get_idx(p_parent_, idx_));
+      } else {
+        value_.clear();
+      }
     } else {
       value_.set_failbit();
     }
@@ -150,10 +245,18 @@ public:
            && json_object_object_length(p_parent_) > 1;
   }
 
+  size_t do_size_hint() const override
+  {
+    if (!json_object_is_type(p_parent_, json_type_object)) return 0;
+    size_t length = json_object_object_length(p_parent_);
+    return (idx_ < length ? length - idx_ : 0);
+  }
+
   jsonc_object_ijsource(shared_ptr<ijstate> const& p_is,
                         json_object * p_parent)
     : jsonc_parsed_ijsource(p_is, p_parent)
     , p_member_(NULL)
+    , idx_(0)
   {
     BOOST_ASSERT(json_object_is_type(p_parent_, json_type_object));
     if (json_object_is_type(p_parent_, json_type_object)) {
@@ -165,13 +268,18 @@ public:
 private:
   void init()
   {
-    value_.reset((p_member_ ? (struct json_object*)p_member_->v : NULL));
+    if (p_member_) {
+      value_.reset((struct json_object*)p_member_->v);
+    } else {
+      value_.clear();
+    }
     value_.set_key(p_member_ ? (char const*)p_member_->k : "");
   }
 
   void do_advance() override;
 
   lh_entry * p_member_;
+  size_t idx_;
 };
 
 void jsonc_object_ijsource::do_advance()
@@ -180,6 +288,7 @@ void jsonc_object_ijsource::do_advance()
   if (p_parent_) {
     if (p_member_) {
       p_member_ = p_member_->next;
+      ++idx_;
     }
   }
   init();
@@ -214,14 +323,15 @@ public:
   //! Reinitialize parser to initial state for fresh new parsing.
   void clear();
 
-  //! Either parse_some return an object or expecting is true.
-  //! Return of nullptr with expecting() returning false means error.
+  //! Either parse_some returns true with the parsed object in dest,
+  //! where nullptr is JSON null, or expecting is true.
+  //! Return of false with expecting() returning false means error.
   //! On success pointer 'it' is incremented by chars parsed.
-  json_object * parse_some(const char * & it, streamsize len);
+  bool parse_some(const char * & it, streamsize len, json_object * & dest);
 
   //! Call only when expecting
-  //! Return of nullptr means error.
-  json_object * induce_parse();
+  //! Return of false means error.
+  bool induce_parse(json_object * & dest);
 };
 
 bool jsonc_parser_facade::parsing()
@@ -235,36 +345,39 @@ void jsonc_parser_facade::clear()
   json_tokener_reset(p_toky_);
 }
 
-json_object * jsonc_parser_facade::parse_some(const char * & it, streamsize n)
+bool jsonc_parser_facade::parse_some(const char * & it, streamsize n,
+                                     json_object * & dest)
 {
-  json_object * ret = json_tokener_parse_ex(p_toky_, it, n);
+  dest = json_tokener_parse_ex(p_toky_, it, n);
   json_tokener_error err = json_tokener_get_error(p_toky_);
   if (err != json_tokener_continue && err != json_tokener_success) {
-    BOOST_ASSERT(!ret);
+    BOOST_ASSERT(!dest);
     json_tokener_reset(p_toky_);
   }
   if (p_toky_->char_offset >= 0) {
     it += p_toky_->char_offset;
   } else {
-    BOOST_ASSERT(!ret);
-    ret = nullptr;
+    BOOST_ASSERT(!dest);
+    return false;
   }
-  return ret;
+  return err == json_tokener_success;
 }
 
-json_object * jsonc_parser_facade::induce_parse()
+bool jsonc_parser_facade::induce_parse(json_object * & dest)
 {
   BOOST_ASSERT(this->parsing());
-  json_object * ret = nullptr;
+  dest = nullptr;
   if (this->parsing()) {
-    ret = json_tokener_parse_ex(p_toky_, "", -1);
+    dest = json_tokener_parse_ex(p_toky_, "", -1);
     json_tokener_error err = json_tokener_get_error(p_toky_);
     if (err != json_tokener_success) {
+      BOOST_ASSERT(!dest);
       json_tokener_reset(p_toky_);
+      return false;
     }
-    BOOST_ASSERT( bool(ret) == (err == json_tokener_success) );
+    return true;
   }
-  return ret;
+  return false;
 }
 
 // jsonc_istream_parser
@@ -293,7 +406,7 @@ private:
 void jsonc_istream_parser::do_clear()
 {
   jsonc_.clear();
-  value_.reset();
+  value_.clear();
 }
 
 void jsonc_istream_parser::do_parse(shared_ptr<istream_facade> const& p_is)
@@ -304,8 +417,10 @@ void jsonc_istream_parser::do_parse(shared_ptr<istream_facade> const& p_is)
   }
   while (is.avail() > 0 && value_.is_empty() && !is.fail()) {
     const char * it = is.begin();
-    value_.reset_already_refcounted(jsonc_.parse_some(it, is.avail()));
-    if (value_.is_empty()) {
+    json_object * p_parsed = nullptr;
+    if (jsonc_.parse_some(it, is.avail(), p_parsed)) {
+      value_.reset_already_refcounted(p_parsed);
+    } else {
       BOOST_ASSERT( jsonc_.parsing() == (it != is.begin()) );
       if (!jsonc_.parsing() || it == is.begin()) {
         is.set_failbit();
@@ -314,8 +429,10 @@ void jsonc_istream_parser::do_parse(shared_ptr<istream_facade> const& p_is)
     is.remove_until(it);
   }
   if (is.eof() && jsonc_.parsing()) {
-    value_.reset_already_refcounted(jsonc_.induce_parse());
-    if (value_.is_empty()) {
+    json_object * p_parsed = nullptr;
+    if (jsonc_.induce_parse(p_parsed)) {
+      value_.reset_already_refcounted(p_parsed);
+    } else {
       is.set_failbit();
     }
   }
@@ -424,8 +541,7 @@ ijarray jsonc_value::do_begin_array()
     set_failbit();
     return ijarray();
   }
-  return shared_ptr<ijsource>(new jsonc_array_ijsource(p_state_,
-                                                       jsonc_ptr()));
+  return ijarray(make_shared<jsonc_array_ijsource>(p_state_, jsonc_ptr()));
 }
 
 ijobject jsonc_value::do_begin_object()
@@ -434,8 +550,8 @@ ijobject jsonc_value::do_begin_object()
     set_failbit();
     return ijobject();
   }
-  return shared_ptr<ijsource>(new jsonc_object_ijsource(p_state_,
-                                                        jsonc_ptr()));
+  return ijobject(make_shared<jsonc_object_ijsource>(p_state_,
+                                                     jsonc_ptr()));
 }
 
 // factory function
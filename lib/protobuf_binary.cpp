@@ -0,0 +1,1112 @@
+#include <jios/protobuf_binary.hpp>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <sstream>
+#include <boost/assert.hpp>
+#include <google/protobuf/wire_format_lite.h>
+
+using namespace std;
+using google::protobuf::Descriptor;
+using google::protobuf::EnumValueDescriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace jios {
+
+
+namespace {
+
+typedef WireFormatLite::WireType wire_type;
+
+wire_type wire_type_of(FieldDescriptor const* field)
+{
+  return WireFormatLite::WireTypeForFieldType(
+      static_cast<WireFormatLite::FieldType>(field->type()));
+}
+
+void append_varint(string & dest, uint64_t value)
+{
+  while (value >= 0x80) {
+    dest += static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  dest += static_cast<char>(value);
+}
+
+//! Append the low bytes of value, little-endian
+void append_fixed(string & dest, uint64_t value, size_t bytes)
+{
+  for (size_t i = 0; i < bytes; ++i) {
+    dest += static_cast<char>(value >> (8 * i));
+  }
+}
+
+void append_tag(string & dest, int number, wire_type t)
+{
+  append_varint(dest, WireFormatLite::MakeTag(number, t));
+}
+
+void append_delimited(string & dest, int number, string const& bytes)
+{
+  append_tag(dest, number, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  append_varint(dest, bytes.size());
+  dest += bytes;
+}
+
+bool read_varint(char const* & p, char const* end, uint64_t & dest)
+{
+  dest = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    dest |= uint64_t(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+//! Read a value of wire type t at p into bits, or into [data, data_end)
+//! if length-delimited. Groups are not supported.
+bool read_wire_value(char const* & p, char const* end, wire_type t,
+                     uint64_t & bits,
+                     char const* & data, char const* & data_end)
+{
+  typedef uint8_t const* bytes;
+  switch (t) {
+    case WireFormatLite::WIRETYPE_VARINT:
+      return read_varint(p, end, bits);
+    case WireFormatLite::WIRETYPE_FIXED64:
+      if (end - p < 8) return false;
+      CodedInputStream::ReadLittleEndian64FromArray(
+          reinterpret_cast<bytes>(p), &bits);
+      p += 8;
+      return true;
+    case WireFormatLite::WIRETYPE_FIXED32:
+      {
+        if (end - p < 4) return false;
+        uint32_t v;
+        CodedInputStream::ReadLittleEndian32FromArray(
+            reinterpret_cast<bytes>(p), &v);
+        bits = v;
+        p += 4;
+      }
+      return true;
+    case WireFormatLite::WIRETYPE_LENGTH_DELIMITED:
+      {
+        uint64_t len;
+        if (!read_varint(p, end, len) || len > uint64_t(end - p)) {
+          return false;
+        }
+        data = p;
+        data_end = p + len;
+        p += len;
+      }
+      return true;
+    default:
+      break;
+  }
+  return false;
+}
+
+template<typename T>
+bool read_value(ijvalue & src, T & dest)
+{
+  dest = T();
+  return src.read(dest);
+}
+
+//! Read an unsigned 64-bit value, from the number text of integers
+//! since those above INT64_MAX do not read as int64_t
+bool read_uint64(ijvalue & src, uint64_t & dest)
+{
+  if (src.type() != json_type::jinteger) return read_value(src, dest);
+  boost::string_ref text = src.raw_number();
+  if (src.fail()) return false;
+  dest = 0;
+  for (char c : text) {
+    uint64_t digit = c - '0';
+    if (c < '0' || c > '9'
+        || dest > (numeric_limits<uint64_t>::max() - digit) / 10) {
+      src.set_failbit();
+      return false;
+    }
+    dest = dest * 10 + digit;
+  }
+  if (text.empty()) {
+    src.set_failbit();
+    return false;
+  }
+  return true;
+}
+
+bool is_uint64(FieldDescriptor const* field)
+{
+  return field->type() == FieldDescriptor::TYPE_UINT64
+      || field->type() == FieldDescriptor::TYPE_FIXED64;
+}
+
+//! Set of fields of a message by index, allocating only for messages
+//! of more than 64 fields
+
+class field_set
+{
+public:
+  explicit field_set(int field_count)
+    : low_(0)
+    , high_(field_count > 64 ? field_count - 64 : 0)
+  {}
+
+  void clear()
+  {
+    low_ = 0;
+    fill(high_.begin(), high_.end(), false);
+  }
+
+  //! Add field index i, returning false if already present
+  bool insert(int i)
+  {
+    if (i < 64) {
+      uint64_t bit = uint64_t(1) << i;
+      if (low_ & bit) return false;
+      low_ |= bit;
+      return true;
+    }
+    if (high_[i - 64]) return false;
+    high_[i - 64] = true;
+    return true;
+  }
+
+private:
+  uint64_t low_;
+  vector<bool> high_;
+};
+
+} // namespace
+
+// proto_encoder
+
+proto_encoder::proto_encoder(Descriptor const* desc)
+  : desc_(desc)
+  , levels_(1)
+{
+  BOOST_ASSERT(desc);
+}
+
+string const& proto_encoder::encode(ijvalue & src)
+{
+  encode_message(src, desc_, 0);
+  return levels_[0];
+}
+
+int proto_encoder::required_count(Descriptor const* desc)
+{
+  auto it = required_.find(desc);
+  if (it == required_.end()) {
+    int count = 0;
+    for (int i = 0; i < desc->field_count(); ++i) {
+      if (desc->field(i)->is_required()) { ++count; }
+    }
+    it = required_.emplace(desc, count).first;
+  }
+  return it->second;
+}
+
+//! Encode object src as message desc into levels_[depth]
+void proto_encoder::encode_message(ijvalue & src,
+                                   Descriptor const* desc,
+                                   size_t depth)
+{
+  if (levels_.size() <= depth) { levels_.resize(depth + 1); }
+  levels_[depth].clear();
+  // a repeated key must not count a required field twice
+  field_set required_seen(desc->field_count());
+  int required = 0;
+  ijobject ijo = src.object();
+  while (!ijo.at_end()) {
+    FieldDescriptor const* field = desc->FindFieldByName(ijo.key());
+    if (!field || field->type() == FieldDescriptor::TYPE_GROUP) {
+      src.set_failbit();
+      return;
+    }
+    if (field->is_required() && required_seen.insert(field->index())) {
+      ++required;
+    }
+    encode_field(ijo.get(), field, depth);
+    // stop before advancing past a failed value
+    if (ijo.fail()) return;
+  }
+  if (!src.fail() && required < required_count(desc)) {
+    src.set_failbit();
+  }
+}
+
+//! Append entries of field with value src to levels_[depth].
+//! levels_ may grow, so elements are not referenced across calls.
+void proto_encoder::encode_field(ijvalue & src,
+                                 FieldDescriptor const* field,
+                                 size_t depth)
+{
+  int const number = field->number();
+  if (field->is_repeated()) {
+    ijarray ija = src.array();
+    if (field->is_packed()) {
+      if (levels_.size() <= depth + 1) { levels_.resize(depth + 2); }
+      string & packed = levels_[depth + 1];
+      packed.clear();
+      while (!ija.at_end()) {
+        if (!encode_scalar(ija.get(), field, packed)) return;
+      }
+      if (!packed.empty()) {
+        append_delimited(levels_[depth], number, packed);
+      }
+    } else {
+      while (!ija.at_end()) {
+        encode_field_value(ija.get(), field, depth);
+        if (ija.fail()) return;
+      }
+    }
+  } else {
+    encode_field_value(src, field, depth);
+  }
+}
+
+void proto_encoder::encode_field_value(ijvalue & src,
+                                       FieldDescriptor const* field,
+                                       size_t depth)
+{
+  if (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+    encode_message(src, field->message_type(), depth + 1);
+    if (!src.fail()) {
+      append_delimited(levels_[depth], field->number(), levels_[depth + 1]);
+    }
+  } else {
+    append_tag(levels_[depth], field->number(), wire_type_of(field));
+    encode_scalar(src, field, levels_[depth]);
+  }
+}
+
+//! Append the wire value, without tag, of non-message field value src
+bool proto_encoder::encode_scalar(ijvalue & src,
+                                  FieldDescriptor const* field,
+                                  string & dest)
+{
+  switch (field->type()) {
+    case FieldDescriptor::TYPE_INT32:
+      {
+        int32_t v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, int64_t(v));
+      }
+      break;
+    case FieldDescriptor::TYPE_INT64:
+      {
+        int64_t v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, v);
+      }
+      break;
+    case FieldDescriptor::TYPE_UINT32:
+      {
+        uint32_t v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, v);
+      }
+      break;
+    case FieldDescriptor::TYPE_UINT64:
+      {
+        uint64_t v;
+        if (!read_uint64(src, v)) return false;
+        append_varint(dest, v);
+      }
+      break;
+    case FieldDescriptor::TYPE_SINT32:
+      {
+        int32_t v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, WireFormatLite::ZigZagEncode32(v));
+      }
+      break;
+    case FieldDescriptor::TYPE_SINT64:
+      {
+        int64_t v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, WireFormatLite::ZigZagEncode64(v));
+      }
+      break;
+    case FieldDescriptor::TYPE_BOOL:
+      {
+        bool v;
+        if (!read_value(src, v)) return false;
+        append_varint(dest, v);
+      }
+      break;
+    case FieldDescriptor::TYPE_FIXED32:
+      {
+        uint32_t v;
+        if (!read_value(src, v)) return false;
+        append_fixed(dest, v, 4);
+      }
+      break;
+    case FieldDescriptor::TYPE_SFIXED32:
+      {
+        int32_t v;
+        if (!read_value(src, v)) return false;
+        append_fixed(dest, uint32_t(v), 4);
+      }
+      break;
+    case FieldDescriptor::TYPE_FIXED64:
+      {
+        uint64_t v;
+        if (!read_uint64(src, v)) return false;
+        append_fixed(dest, v, 8);
+      }
+      break;
+    case FieldDescriptor::TYPE_SFIXED64:
+      {
+        int64_t v;
+        if (!read_value(src, v)) return false;
+        append_fixed(dest, v, 8);
+      }
+      break;
+    case FieldDescriptor::TYPE_FLOAT:
+      {
+        float v;
+        if (!read_value(src, v)) return false;
+        append_fixed(dest, WireFormatLite::EncodeFloat(v), 4);
+      }
+      break;
+    case FieldDescriptor::TYPE_DOUBLE:
+      {
+        double v;
+        if (!read_value(src, v)) return false;
+        append_fixed(dest, WireFormatLite::EncodeDouble(v), 8);
+      }
+      break;
+    case FieldDescriptor::TYPE_ENUM:
+      {
+        int32_t v;
+        if (src.type() == json_type::jstring) {
+          if (!src.read(text_)) return false;
+          EnumValueDescriptor const* ev
+              = field->enum_type()->FindValueByName(text_);
+          if (!ev) {
+            src.set_failbit();
+            return false;
+          }
+          v = ev->number();
+        } else if (!read_value(src, v)) {
+          return false;
+        }
+        append_varint(dest, int64_t(v));
+      }
+      break;
+    case FieldDescriptor::TYPE_STRING:
+    case FieldDescriptor::TYPE_BYTES:
+      if (!src.read(text_)) return false;
+      append_varint(dest, text_.size());
+      dest += text_;
+      break;
+    default:
+      src.set_failbit();
+      return false;
+  }
+  return true;
+}
+
+size_t write_delimited(ijstream & src,
+                       Descriptor const* desc,
+                       CodedOutputStream & out,
+                       size_t max_count)
+{
+  proto_encoder encoder(desc);
+  size_t count = 0;
+  while (count < max_count && !src.at_end()) {
+    string const& bytes = encoder.encode(src.get());
+    if (src.fail()) break;
+    out.WriteVarint32(bytes.size());
+    out.WriteRaw(bytes.data(), bytes.size());
+    ++count;
+  }
+  return count;
+}
+
+// protobuf binary back-end
+
+class proto_wire_state : public ijstate
+{
+public:
+  proto_wire_state() : failbit_(false) {}
+
+  bool failed() const { return failbit_; }
+
+private:
+  bool do_get_failbit() const override { return failbit_; }
+  void do_set_failbit() override { failbit_ = true; }
+
+  bool failbit_;
+};
+
+class proto_wire_ijsource;
+
+//! A message, the entries of a repeated field read as an array, or
+//! one value of a field, in a buffer of binary messages
+
+class proto_wire_value : public ijpair
+{
+public:
+  proto_wire_value(shared_ptr<proto_wire_state> const& p_state,
+                   shared_ptr<string const> const& p_buf)
+    : p_state_(p_state)
+    , p_buf_(p_buf)
+    , kind_(kind::message)
+    , desc_(nullptr)
+    , field_(nullptr)
+    , bits_(0)
+    , p_(nullptr)
+    , end_(nullptr)
+  {}
+
+  void set_buffer(shared_ptr<string const> const& p_buf) { p_buf_ = p_buf; }
+
+  //! message of type desc in [p, end)
+  void reset_message(Descriptor const* desc, char const* p, char const* end)
+  {
+    kind_ = kind::message;
+    desc_ = desc;
+    field_ = nullptr;
+    p_ = p;
+    end_ = end;
+  }
+
+  //! entries of repeated field in [p, end), starting at a tag and
+  //! skipping entries of other fields
+  void reset_repeated(FieldDescriptor const* field,
+                      char const* p, char const* end)
+  {
+    kind_ = kind::repeated;
+    field_ = field;
+    p_ = p;
+    end_ = end;
+  }
+
+  //! value of field as bits, or in [p, end) if length-delimited
+  void reset_element(FieldDescriptor const* field, uint64_t bits,
+                     char const* p, char const* end)
+  {
+    kind_ = kind::element;
+    field_ = field;
+    bits_ = bits;
+    p_ = p;
+    end_ = end;
+  }
+
+  bool failed() const { return p_state_->failed(); }
+
+private:
+  enum class kind { message, repeated, element };
+
+  bool mismatch() { this->set_failbit(); return false; }
+
+  bool parse(int64_t & dest);
+  bool parse(double & dest);
+  bool parse_text(char const* & p, size_t & len, string & tmp);
+  bool unsigned_text(char const* & p, size_t & len);
+
+  shared_ptr<proto_wire_ijsource> sub_source(bool object);
+
+  ijstate & do_state() override { return *p_state_; }
+  ijstate const& do_state() const override { return *p_state_; }
+
+  json_type do_type() const override;
+
+  void do_parse(int64_t & dest) override { parse(dest); }
+  void do_parse(double & dest) override { parse(dest); }
+
+  void do_parse(bool & dest) override
+  {
+    if (kind_ != kind::element
+        || field_->cpp_type() != FieldDescriptor::CPPTYPE_BOOL) {
+      mismatch();
+      return;
+    }
+    dest = (bits_ != 0);
+  }
+
+  void do_parse(string & dest) override
+  {
+    char const* p = nullptr;
+    size_t len = 0;
+    string tmp;
+    if (parse_text(p, len, tmp)) {
+      dest.assign(p, p + len);
+    } else {
+      mismatch();
+    }
+  }
+
+  void do_parse(buffer_iterator dest) override
+  {
+    char const* p = nullptr;
+    size_t len = 0;
+    string tmp;
+    if (parse_text(p, len, tmp)) {
+      copy(p, p + len, dest);
+    } else {
+      mismatch();
+    }
+  }
+
+  ijarray do_begin_array() override;
+  ijobject do_begin_object() override;
+
+  bool do_raw_json(char const* & p, size_t & len) override
+  {
+    return unsigned_text(p, len);
+  }
+
+  boost::string_ref do_raw_number() override
+  {
+    char const* p = nullptr;
+    size_t len = 0;
+    if (unsigned_text(p, len)) return boost::string_ref(p, len);
+    return ijvalue::do_raw_number();
+  }
+
+  string do_key() const override
+  {
+    return (field_ ? field_->name() : string());
+  }
+
+  boost::string_ref do_key_ref() const override
+  {
+    return (field_ ? boost::string_ref(field_->name()) : boost::string_ref());
+  }
+
+  shared_ptr<proto_wire_state> p_state_;
+  shared_ptr<string const> p_buf_;
+  kind kind_;
+  Descriptor const* desc_;
+  FieldDescriptor const* field_;
+  uint64_t bits_;
+  char const* p_;
+  char const* end_;
+  char text_[24];
+};
+
+//! Fields of a message, or elements of a repeated field
+
+class proto_wire_ijsource : public ijsource
+{
+public:
+  //! source of the fields of message desc in [p, end)
+  proto_wire_ijsource(shared_ptr<proto_wire_state> const& p_state,
+                      shared_ptr<string const> const& p_buf,
+                      Descriptor const* desc,
+                      char const* p, char const* end)
+    : value_(p_state, p_buf)
+    , desc_(desc)
+    , field_(nullptr)
+    , pos_(p)
+    , end_(end)
+    , packed_(nullptr)
+    , packed_end_(nullptr)
+    , at_end_(false)
+    , seen_(desc ? desc->field_count() : 0)
+    , scattered_(desc && has_scattered_fields())
+  {
+    next();
+  }
+
+  //! source of the elements of the entries of field in [p, end)
+  proto_wire_ijsource(shared_ptr<proto_wire_state> const& p_state,
+                      shared_ptr<string const> const& p_buf,
+                      FieldDescriptor const* field,
+                      char const* p, char const* end)
+    : value_(p_state, p_buf)
+    , desc_(nullptr)
+    , field_(field)
+    , pos_(p)
+    , end_(end)
+    , packed_(nullptr)
+    , packed_end_(nullptr)
+    , at_end_(false)
+    , seen_(0)
+    , scattered_(false)
+  {
+    next();
+  }
+
+private:
+  bool fail()
+  {
+    value_.set_failbit();
+    at_end_ = true;
+    return false;
+  }
+
+  void next()
+  {
+    if (field_) {
+      next_element();
+    } else {
+      next_field();
+    }
+  }
+
+  //! Whether a known field has entries that are not all consecutive,
+  //! or a singular field has more than one entry. Malformed entries are
+  //! left for next_field to report.
+  bool has_scattered_fields()
+  {
+    char const* p = pos_;
+    int prev_number = 0;
+    FieldDescriptor const* prev = nullptr;
+    while (p < end_) {
+      uint64_t tag;
+      uint64_t bits = 0;
+      char const* data = nullptr;
+      char const* data_end = nullptr;
+      if (!read_varint(p, end_, tag)
+          || !read_wire_value(p, end_, WireFormatLite::GetTagWireType(tag),
+                              bits, data, data_end)) {
+        break;
+      }
+      int const number = WireFormatLite::GetTagFieldNumber(tag);
+      if (number == prev_number && prev && prev->is_repeated()) continue;
+      prev_number = number;
+      prev = desc_->FindFieldByNumber(number);
+      if (prev && !seen_.insert(prev->index())) {
+        seen_.clear();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //! Position value_ at the next known field, skipping unknown fields.
+  //! Fields with scattered entries are positioned at their first entry
+  //! and skipped at later ones.
+  void next_field()
+  {
+    while (pos_ < end_ && !value_.failed()) {
+      char const* entry = pos_;
+      uint64_t tag;
+      if (!read_varint(pos_, end_, tag)) { fail(); return; }
+      int const number = WireFormatLite::GetTagFieldNumber(tag);
+      wire_type const t = WireFormatLite::GetTagWireType(tag);
+      uint64_t bits = 0;
+      char const* data = nullptr;
+      char const* data_end = nullptr;
+      if (!read_wire_value(pos_, end_, t, bits, data, data_end)) {
+        fail();
+        return;
+      }
+      FieldDescriptor const* field = desc_->FindFieldByNumber(number);
+      if (!field) continue;
+      if (scattered_) {
+        if (!seen_.insert(field->index())) continue;
+        if (field->is_repeated()) {
+          // all entries of the field up to the end form one array
+          value_.reset_repeated(field, entry, end_);
+          return;
+        }
+        if (t != wire_type_of(field)
+            || !last_entry(field, bits, data, data_end)) {
+          fail();
+          return;
+        }
+        value_.reset_element(field, bits, data, data_end);
+        return;
+      }
+      if (field->is_repeated()) {
+        // consecutive entries of the field form one array
+        char const* run_end = pos_;
+        while (pos_ < end_) {
+          uint64_t next_tag;
+          if (!read_varint(pos_, end_, next_tag)) { fail(); return; }
+          if (WireFormatLite::GetTagFieldNumber(next_tag) != number) break;
+          if (!read_wire_value(pos_, end_,
+                               WireFormatLite::GetTagWireType(next_tag),
+                               bits, data, data_end)) {
+            fail();
+            return;
+          }
+          run_end = pos_;
+        }
+        pos_ = run_end;
+        value_.reset_repeated(field, entry, run_end);
+      } else {
+        if (t != wire_type_of(field)) { fail(); return; }
+        value_.reset_element(field, bits, data, data_end);
+      }
+      return;
+    }
+    at_end_ = true;
+  }
+
+  //! Take the value of the last entry of singular field after pos_,
+  //! as the parser does for scalars. A message field must not repeat
+  //! since its entries would merge.
+  bool last_entry(FieldDescriptor const* field, uint64_t & bits,
+                  char const* & data, char const* & data_end)
+  {
+    bool const message
+        = (field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE);
+    char const* p = pos_;
+    while (p < end_) {
+      uint64_t tag;
+      if (!read_varint(p, end_, tag)) return false;
+      wire_type const t = WireFormatLite::GetTagWireType(tag);
+      uint64_t next_bits = 0;
+      char const* next_data = nullptr;
+      char const* next_data_end = nullptr;
+      if (!read_wire_value(p, end_, t, next_bits, next_data, next_data_end)) {
+        return false;
+      }
+      if (WireFormatLite::GetTagFieldNumber(tag) != field->number()) continue;
+      if (message || t != wire_type_of(field)) return false;
+      bits = next_bits;
+      data = next_data;
+      data_end = next_data_end;
+    }
+    return true;
+  }
+
+  //! Position value_ at the next element, within packed entries or not
+  void next_element()
+  {
+    wire_type const expected = wire_type_of(field_);
+    uint64_t bits = 0;
+    char const* data = nullptr;
+    char const* data_end = nullptr;
+    while (!value_.failed()) {
+      if (packed_ < packed_end_) {
+        if (!read_wire_value(packed_, packed_end_, expected,
+                             bits, data, data_end)) {
+          fail();
+          return;
+        }
+        value_.reset_element(field_, bits, nullptr, nullptr);
+        return;
+      }
+      if (pos_ >= end_) break;
+      uint64_t tag;
+      if (!read_varint(pos_, end_, tag)) { fail(); return; }
+      wire_type const t = WireFormatLite::GetTagWireType(tag);
+      if (!read_wire_value(pos_, end_, t, bits, data, data_end)) {
+        fail();
+        return;
+      }
+      if (WireFormatLite::GetTagFieldNumber(tag) != field_->number()) {
+        continue;
+      }
+      if (t == expected) {
+        value_.reset_element(field_, bits, data, data_end);
+        return;
+      }
+      if (t != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) { fail(); return; }
+      packed_ = data;
+      packed_end_ = data_end;
+    }
+    at_end_ = true;
+  }
+
+  ijstate & do_state() override { return value_.state(); }
+  ijstate const& do_state() const override { return value_.state(); }
+
+  ijpair & do_ref() override { return value_; }
+
+  bool do_is_terminator() override { return at_end_ || value_.failed(); }
+
+  void do_advance() override { next(); }
+
+  bool do_expecting() override { return false; }
+
+  proto_wire_value value_;
+  Descriptor const* const desc_;
+  FieldDescriptor const* const field_;
+  char const* pos_;
+  char const* const end_;
+  char const* packed_;
+  char const* packed_end_;
+  bool at_end_;
+  //! fields already positioned at, if scattered_
+  field_set seen_;
+  bool const scattered_;
+};
+
+// proto_wire_value
+
+json_type proto_wire_value::do_type() const
+{
+  switch (kind_) {
+    case kind::message:  return json_type::jobject;
+    case kind::repeated: return json_type::jarray;
+    case kind::element:  break;
+  }
+  switch (field_->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_MESSAGE: return json_type::jobject;
+    case FieldDescriptor::CPPTYPE_STRING:  return json_type::jstring;
+    case FieldDescriptor::CPPTYPE_ENUM:    return json_type::jstring;
+    case FieldDescriptor::CPPTYPE_BOOL:    return json_type::jbool;
+    case FieldDescriptor::CPPTYPE_FLOAT:   return json_type::jfloat;
+    case FieldDescriptor::CPPTYPE_DOUBLE:  return json_type::jfloat;
+    default:
+      break;
+  }
+  return json_type::jinteger;
+}
+
+bool proto_wire_value::parse(int64_t & dest)
+{
+  if (kind_ != kind::element) return mismatch();
+  switch (field_->type()) {
+    case FieldDescriptor::TYPE_INT32:
+    case FieldDescriptor::TYPE_SFIXED32:
+      dest = static_cast<int32_t>(bits_);
+      return true;
+    case FieldDescriptor::TYPE_UINT32:
+    case FieldDescriptor::TYPE_FIXED32:
+      dest = static_cast<uint32_t>(bits_);
+      return true;
+    case FieldDescriptor::TYPE_UINT64:
+    case FieldDescriptor::TYPE_FIXED64:
+      // values above INT64_MAX are only read as text or double
+      if (bits_ > uint64_t(numeric_limits<int64_t>::max())) {
+        return mismatch();
+      }
+      dest = static_cast<int64_t>(bits_);
+      return true;
+    case FieldDescriptor::TYPE_INT64:
+    case FieldDescriptor::TYPE_SFIXED64:
+      dest = static_cast<int64_t>(bits_);
+      return true;
+    case FieldDescriptor::TYPE_SINT32:
+      dest = WireFormatLite::ZigZagDecode32(static_cast<uint32_t>(bits_));
+      return true;
+    case FieldDescriptor::TYPE_SINT64:
+      dest = WireFormatLite::ZigZagDecode64(bits_);
+      return true;
+    default:
+      break;
+  }
+  return mismatch();
+}
+
+bool proto_wire_value::parse(double & dest)
+{
+  if (kind_ == kind::element) {
+    switch (field_->type()) {
+      case FieldDescriptor::TYPE_FLOAT:
+        dest = WireFormatLite::DecodeFloat(static_cast<uint32_t>(bits_));
+        return true;
+      case FieldDescriptor::TYPE_DOUBLE:
+        dest = WireFormatLite::DecodeDouble(bits_);
+        return true;
+      case FieldDescriptor::TYPE_UINT64:
+      case FieldDescriptor::TYPE_FIXED64:
+        dest = bits_;
+        return true;
+      default:
+        break;
+    }
+  }
+  int64_t i;
+  if (!parse(i)) return false;
+  dest = i;
+  return true;
+}
+
+bool proto_wire_value::parse_text(char const* & p, size_t & len,
+                                  string & tmp)
+{
+  if (kind_ != kind::element) return false;
+  switch (field_->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      p = p_;
+      len = end_ - p_;
+      return true;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      {
+        int32_t number = static_cast<int32_t>(bits_);
+        EnumValueDescriptor const* ev
+            = field_->enum_type()->FindValueByNumber(number);
+        if (ev) {
+          p = ev->name().data();
+          len = ev->name().size();
+          return true;
+        }
+        tmp = to_string(number);
+      }
+      break;
+    case FieldDescriptor::CPPTYPE_BOOL:
+      tmp = (bits_ ? "true" : "false");
+      break;
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      {
+        double d;
+        if (!parse(d)) return false;
+        ostringstream ss;
+        ss << d;
+        tmp = ss.str();
+      }
+      break;
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return false;
+    case FieldDescriptor::CPPTYPE_UINT64:
+      tmp = to_string(bits_);
+      break;
+    default:
+      {
+        int64_t i;
+        if (!parse(i)) return false;
+        tmp = to_string(i);
+      }
+      break;
+  }
+  p = tmp.data();
+  len = tmp.size();
+  return true;
+}
+
+//! Decimal text of an unsigned 64-bit element, in text_
+bool proto_wire_value::unsigned_text(char const* & p, size_t & len)
+{
+  if (kind_ != kind::element || !is_uint64(field_)) return false;
+  len = snprintf(text_, sizeof(text_), "%" PRIu64, bits_);
+  p = text_;
+  return true;
+}
+
+shared_ptr<proto_wire_ijsource> proto_wire_value::sub_source(bool object)
+{
+  if (object) {
+    if (kind_ == kind::message) {
+      return make_shared<proto_wire_ijsource>(p_state_, p_buf_,
+                                              desc_, p_, end_);
+    }
+    if (kind_ == kind::element
+        && field_->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE) {
+      return make_shared<proto_wire_ijsource>(p_state_, p_buf_,
+                                              field_->message_type(),
+                                              p_, end_);
+    }
+  } else if (kind_ == kind::repeated) {
+    return make_shared<proto_wire_ijsource>(p_state_, p_buf_,
+                                            field_, p_, end_);
+  }
+  set_failbit();
+  Descriptor const* none = nullptr;
+  return make_shared<proto_wire_ijsource>(p_state_, p_buf_,
+                                          none, nullptr, nullptr);
+}
+
+ijarray proto_wire_value::do_begin_array()
+{
+  return ijarray(sub_source(false));
+}
+
+ijobject proto_wire_value::do_begin_object()
+{
+  return ijobject(sub_source(true));
+}
+
+// proto_delimited_ijsource
+
+//! Top-level source of length-delimited messages read from an istream
+
+class proto_delimited_ijsource : public ijsource
+{
+public:
+  proto_delimited_ijsource(istream & is, Descriptor const* desc,
+                           size_t max_size)
+    : is_(is)
+    , desc_(desc)
+    , max_size_(max_size)
+    , p_state_(make_shared<proto_wire_state>())
+    , value_(p_state_, nullptr)
+    , loaded_(false)
+    , at_end_(false)
+  {}
+
+private:
+  void load()
+  {
+    if (loaded_) return;
+    loaded_ = true;
+    int c = is_.get();
+    if (c == EOF) {
+      at_end_ = true;
+      return;
+    }
+    uint64_t len = 0;
+    for (int shift = 0; ; shift += 7) {
+      if (c == EOF || shift >= 64) {
+        value_.set_failbit();
+        return;
+      }
+      len |= uint64_t(c & 0x7F) << shift;
+      if (!(c & 0x80)) break;
+      c = is_.get();
+    }
+    if (len > max_size_) {
+      value_.set_failbit();
+      return;
+    }
+    // reuse the buffer unless sub-sources of a previous message hold it
+    if (!p_buf_ || p_buf_.use_count() > 2) {
+      p_buf_ = make_shared<string>();
+      value_.set_buffer(p_buf_);
+    }
+    p_buf_->resize(len);
+    is_.read(&(*p_buf_)[0], len);
+    if (uint64_t(is_.gcount()) != len) {
+      value_.set_failbit();
+      return;
+    }
+    char const* p = p_buf_->data();
+    value_.reset_message(desc_, p, p + len);
+  }
+
+  ijstate & do_state() override { return *p_state_; }
+  ijstate const& do_state() const override { return *p_state_; }
+
+  ijpair & do_ref() override
+  {
+    load();
+    return value_;
+  }
+
+  bool do_is_terminator() override
+  {
+    load();
+    return at_end_ || p_state_->failed();
+  }
+
+  void do_advance() override { loaded_ = false; }
+
+  bool do_expecting() override { return false; }
+
+  istream & is_;
+  Descriptor const* const desc_;
+  size_t const max_size_;
+  shared_ptr<proto_wire_state> p_state_;
+  shared_ptr<string> p_buf_;
+  proto_wire_value value_;
+  bool loaded_;
+  bool at_end_;
+};
+
+ijstream protobuf_delimited_in(istream & is, Descriptor const* desc,
+                               size_t max_size)
+{
+  BOOST_ASSERT(desc);
+  return ijstream(make_shared<proto_delimited_ijsource>(is, desc, max_size));
+}
+
+
+} // namespace
@@ -2,7 +2,10 @@
 
 #include <boost/assert.hpp>
 
+using namespace std;
 using namespace google;
+using google::protobuf::Arena;
+using google::protobuf::ArenaOptions;
 using google::protobuf::FieldDescriptor;
 using google::protobuf::Reflection;
 using google::protobuf::Descriptor;
@@ -26,7 +29,7 @@ void parse_field(ijvalue & ij,
       value_type;
   value_type value = value_type();
   if (ij.read(value)) {
-    (reflec->*set_meth)(pro, field, value);
+    (reflec->*set_meth)(pro, field, std::move(value));
   }
 }
 
@@ -163,5 +166,114 @@ void jios_read(ijvalue & ij, protobuf::Message & pro)
   if (!pro.IsInitialized()) { ij.set_failbit(); }
 }
 
+// projections
+
+void merge_projected(ijvalue & ij,
+                     protobuf::Message & pro,
+                     proto_projection const& proj,
+                     int node)
+{
+  Descriptor const* pd = pro.GetDescriptor();
+  Reflection const* reflec = pro.GetReflection();
+  BOOST_ASSERT(pd && reflec);
+  if (!(pd && reflec)) {
+    ij.set_failbit();
+    return;
+  }
+  ijobject ijo = ij.object();
+  while (!ijo.at_end()) {
+    FieldDescriptor const* field = pd->FindFieldByName(ijo.key());
+    if (NULL == field) {
+      ij.set_failbit();
+      return;
+    }
+    int sel = proj.select(node, field);
+    if (sel == proto_projection::none) {
+      ijo.skip();
+    } else if (sel == proto_projection::all) {
+      parse_any_field(ijo.get(), &pro, field, reflec);
+    } else if (field->is_repeated()) {
+      reflec->ClearField(&pro, field);
+      ijarray ija = ijo.get().array();
+      while (!ija.at_end()) {
+        merge_projected(ija.get(), *reflec->AddMessage(&pro, field),
+                        proj, sel);
+      }
+    } else {
+      merge_projected(ijo.get(), *reflec->MutableMessage(&pro, field),
+                      proj, sel);
+    }
+  }
+  // fields selected whole are checked by their own reads
+  for (FieldDescriptor const* field : proj.required(node)) {
+    if (!reflec->HasField(pro, field)) {
+      ij.set_failbit();
+      return;
+    }
+  }
 }
 
+void jios_read(ijvalue & ij, projected_ref<protobuf::Message> const& dest)
+{
+  BOOST_ASSERT(dest.message.GetDescriptor() == dest.projection.descriptor());
+  dest.message.Clear();
+  merge_projected(ij, dest.message, dest.projection, 0);
+}
+
+// proto_arena
+
+namespace {
+
+unique_ptr<Arena> make_arena(vector<char> & block)
+{
+  ArenaOptions options;
+  options.initial_block = block.data();
+  options.initial_block_size = block.size();
+  return unique_ptr<Arena>(new Arena(options));
+}
+
+} // namespace
+
+proto_arena::proto_arena(size_t initial_block_size)
+  : block_(initial_block_size)
+  , arena_(make_arena(block_))
+{
+}
+
+proto_arena::~proto_arena()
+{
+  // destroy the arena before the block it allocates from
+  arena_.reset();
+}
+
+void proto_arena::reset()
+{
+  size_t used = arena_->SpaceAllocated();
+  if (used > block_.size()) {
+    arena_.reset();
+    block_ = vector<char>(used);
+    arena_ = make_arena(block_);
+  } else {
+    arena_->Reset();
+  }
+}
+
+size_t read_batch(ijstream & src,
+                  proto_arena & arena,
+                  protobuf::Message const& prototype,
+                  vector<protobuf::Message *> & dest,
+                  size_t max_count)
+{
+  arena.reset();
+  dest.clear();
+  while (dest.size() < max_count && !src.at_end()) {
+    protobuf::Message * pro = prototype.New(arena.get());
+    src.get().read(*pro);
+    if (src.fail()) break;
+    dest.push_back(pro);
+  }
+  return dest.size();
+}
+
+
+}
@@ -1,12 +1,18 @@
 #include <jios/protobuf_oj.hpp>
 
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <jios/istream_ij.hpp>
 #include <jios/json_out.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
 
 using namespace std;
 using boost::filesystem::path;
 using namespace google;
+using google::protobuf::EnumValueDescriptor;
 using google::protobuf::FieldDescriptor;
 using google::protobuf::Reflection;
 using google::protobuf::Descriptor;
@@ -172,6 +178,76 @@ void jios_write(ojvalue & oj, protobuf::Message const& pro)
   ojo.terminate();
 };
 
+// projections
+
+int projected_count(protobuf::Message const& pro,
+                    Reflection const* reflec,
+                    proto_projection const& proj,
+                    int node)
+{
+  int ret = 0;
+  Descriptor const* pd = pro.GetDescriptor();
+  int N = pd->field_count();
+  for (int i = 0; i < N; ++i) {
+    FieldDescriptor const* field = pd->field(i);
+    if (proj.select(node, field) == proto_projection::none) continue;
+    if (field->is_repeated()) {
+      if (reflec->FieldSize(pro, field) > 0) { ++ret; }
+    } else {
+      if (reflec->HasField(pro, field)) { ++ret; }
+    }
+  }
+  return ret;
+}
+
+void write_projected(ojvalue & oj,
+                     protobuf::Message const& pro,
+                     proto_projection const& proj,
+                     int node)
+{
+  Descriptor const* pd = pro.GetDescriptor();
+  Reflection const* reflec = pro.GetReflection();
+  BOOST_ASSERT(pd && reflec);
+  if (!(pd && reflec)) return;
+  ojobject ojo = oj.object(projected_count(pro, reflec, proj, node) > 1);
+  int N = pd->field_count();
+  for (int i = 0; i < N; ++i) {
+    FieldDescriptor const* field = pd->field(i);
+    int sel = proj.select(node, field);
+    if (sel == proto_projection::none) continue;
+    if (field->is_repeated()) {
+      int M = reflec->FieldSize(pro, field);
+      if (M > 0) {
+        ojarray oja = ojo[field->name()].array(M > 1);
+        for (int j = 0; j < M; ++j) {
+          if (sel >= 0) {
+            write_projected(*oja, reflec->GetRepeatedMessage(pro, field, j),
+                            proj, sel);
+          } else {
+            print_repeated_field(*oja, pro, field, j, reflec);
+          }
+        }
+        oja.terminate();
+      }
+    } else if (reflec->HasField(pro, field)) {
+      if (sel >= 0) {
+        write_projected(ojo[field->name()], reflec->GetMessage(pro, field),
+                        proj, sel);
+      } else {
+        print_singular_field(ojo[field->name()], pro, field, reflec);
+      }
+    }
+  }
+  ojo.terminate();
+}
+
+void jios_write(ojvalue & oj,
+                projected_ref<protobuf::Message const> const& src)
+{
+  BOOST_ASSERT(src.message.GetDescriptor() == src.projection.descriptor());
+  write_projected(oj, src.message, src.projection, 0);
+}
+
 void print_proto_type(ostream & os, protobuf::Message const& pro)
 {
   json_out(os) << pro;
@@ -184,6 +260,318 @@ void print_proto_type(path const& file_path, protobuf::Message const& pro)
   print_proto_type(fs, pro);
 }
 
+// protobuf_ojnode
 
-} // namespace
+//! Sink setting fields of a message, or adding elements to a repeated
+//! field of a message, as values are written. Nodes without a message
+//! discard values written after a failure.
+
+class protobuf_ojnode
+  : public ojsink
+  , boost::noncopyable
+{
+public:
+  //! root node filling dest with each top-level object
+  protobuf_ojnode(protobuf::Message & dest)
+    : failed_(make_shared<bool>(false))
+    , msg_(&dest)
+    , array_field_(nullptr)
+    , field_(nullptr)
+    , root_(true)
+    , check_initialized_(false)
+    , terminated_(false)
+  {}
+
+  //! node of the fields of msg, or of the elements of repeated field
+  //! array_field of msg if not null
+  protobuf_ojnode(shared_ptr<bool> const& failed,
+                  protobuf::Message * msg,
+                  FieldDescriptor const* array_field,
+                  bool check_initialized)
+    : failed_(failed)
+    , msg_(msg)
+    , array_field_(array_field)
+    , field_(array_field)
+    , root_(false)
+    , check_initialized_(check_initialized)
+    , terminated_(false)
+  {}
+
+private:
+  typedef protobuf::Message message;
+
+  //! Field of the next value, or nullptr if discarding
+  FieldDescriptor const* target()
+  {
+    if (!msg_ || *failed_) return nullptr;
+    if (!field_ || (field_->is_repeated() && !array_field_)) {
+      *failed_ = true;
+      return nullptr;
+    }
+    return field_;
+  }
+
+  bool mismatch()
+  {
+    *failed_ = true;
+    return false;
+  }
+
+  template<typename T>
+  void store(T value,
+             void (Reflection::*set_meth)(
+                   message *, FieldDescriptor const*, T) const,
+             void (Reflection::*add_meth)(
+                   message *, FieldDescriptor const*, T) const)
+  {
+    Reflection const* reflec = msg_->GetReflection();
+    if (array_field_) {
+      (reflec->*add_meth)(msg_, field_, std::move(value));
+    } else {
+      (reflec->*set_meth)(msg_, field_, std::move(value));
+    }
+  }
+
+  template<typename T>
+  bool store_in_range(int64_t value,
+                      void (Reflection::*set_meth)(
+                            message *, FieldDescriptor const*, T) const,
+                      void (Reflection::*add_meth)(
+                            message *, FieldDescriptor const*, T) const)
+  {
+    typedef numeric_limits<T> numeric;
+    bool in_range = (numeric::is_signed
+        ? (value >= int64_t(numeric::min())
+           && value <= int64_t(numeric::max()))
+        : (value >= 0 && uint64_t(value) <= uint64_t(numeric::max())));
+    if (!in_range) return mismatch();
+    store(T(value), set_meth, add_meth);
+    return true;
+  }
+
+  void store_enum(EnumValueDescriptor const* value)
+  {
+    if (!value) {
+      mismatch();
+      return;
+    }
+    store(value, &Reflection::SetEnum, &Reflection::AddEnum);
+  }
+
+  bool print_integer(int64_t value)
+  {
+    switch (field_->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        return store_in_range(value, &Reflection::SetInt32,
+                              &Reflection::AddInt32);
+      case FieldDescriptor::CPPTYPE_INT64:
+        store(value, &Reflection::SetInt64, &Reflection::AddInt64);
+        return true;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        return store_in_range(value, &Reflection::SetUInt32,
+                              &Reflection::AddUInt32);
+      case FieldDescriptor::CPPTYPE_UINT64:
+        return store_in_range(value, &Reflection::SetUInt64,
+                              &Reflection::AddUInt64);
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        store(double(value), &Reflection::SetDouble, &Reflection::AddDouble);
+        return true;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        store(float(value), &Reflection::SetFloat, &Reflection::AddFloat);
+        return true;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        store_enum(field_->enum_type()->FindValueByNumber(value));
+        return true;
+      default:
+        break;
+    }
+    return mismatch();
+  }
 
+  void do_print_null() override
+  {
+    if (!target()) return;
+    if (array_field_) {
+      mismatch();
+    } else {
+      msg_->GetReflection()->ClearField(msg_, field_);
+    }
+  }
+
+  void do_print(int64_t value) override
+  {
+    if (target()) { print_integer(value); }
+  }
+
+  void do_print(double value) override
+  {
+    if (!target()) return;
+    switch (field_->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        store(value, &Reflection::SetDouble, &Reflection::AddDouble);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        store(float(value), &Reflection::SetFloat, &Reflection::AddFloat);
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        if (std::trunc(value) == value && value >= 0
+            && value < std::ldexp(1.0, 64)) {
+          store(uint64_t(value), &Reflection::SetUInt64,
+                &Reflection::AddUInt64);
+        } else {
+          mismatch();
+        }
+        break;
+      default:
+        // integral values such as 2.0 fit integer fields
+        if (std::trunc(value) == value
+            && std::abs(value) < std::ldexp(1.0, 63)) {
+          print_integer(int64_t(value));
+        } else {
+          mismatch();
+        }
+        break;
+    }
+  }
+
+  void do_print(bool value) override
+  {
+    if (!target()) return;
+    if (field_->cpp_type() == FieldDescriptor::CPPTYPE_BOOL) {
+      store(value, &Reflection::SetBool, &Reflection::AddBool);
+    } else {
+      mismatch();
+    }
+  }
+
+  void do_print(string_iterator it, string_iterator end) override
+  {
+    if (!target()) return;
+    string value(it, end);
+    switch (field_->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_STRING:
+        store(std::move(value), &Reflection::SetString,
+              &Reflection::AddString);
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        store_enum(field_->enum_type()->FindValueByName(value));
+        break;
+      default:
+        mismatch();
+        break;
+    }
+  }
+
+  //! Node discarding values
+  shared_ptr<protobuf_ojnode> discard()
+  {
+    return make_shared<protobuf_ojnode>(failed_, nullptr, nullptr, false);
+  }
+
+  ojarray do_begin_array(bool) override
+  {
+    if (!msg_ || *failed_) return ojarray(discard());
+    if (root_ || array_field_ || !field_ || !field_->is_repeated()) {
+      mismatch();
+      return ojarray(discard());
+    }
+    msg_->GetReflection()->ClearField(msg_, field_);
+    return ojarray(make_shared<protobuf_ojnode>(failed_, msg_, field_,
+                                                false));
+  }
+
+  ojobject do_begin_object(bool) override
+  {
+    if (root_) {
+      msg_->Clear();
+      return ojobject(make_shared<protobuf_ojnode>(failed_, msg_, nullptr,
+                                                   true));
+    }
+    if (!target()) return ojobject(discard());
+    if (field_->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      mismatch();
+      return ojobject(discard());
+    }
+    Reflection const* reflec = msg_->GetReflection();
+    message * sub = (array_field_ ? reflec->AddMessage(msg_, field_)
+                                  : reflec->MutableMessage(msg_, field_));
+    return ojobject(make_shared<protobuf_ojnode>(failed_, sub, nullptr,
+                                                 false));
+  }
+
+  //! uint64 fields take the text of values, since those above
+  //! INT64_MAX are not written as int64_t
+  bool do_accepts_raw_json(bool structure) const override
+  {
+    return !structure && msg_ && !*failed_ && field_
+        && field_->cpp_type() == FieldDescriptor::CPPTYPE_UINT64;
+  }
+
+  void do_print_raw_json(char const* p, size_t len) override
+  {
+    if (!target()) return;
+    char const* const end = p + len;
+    char const* it = p;
+    uint64_t value = 0;
+    for (; it != end && *it >= '0' && *it <= '9'; ++it) {
+      uint64_t digit = *it - '0';
+      if (value > (numeric_limits<uint64_t>::max() - digit) / 10) {
+        mismatch();
+        return;
+      }
+      value = value * 10 + digit;
+    }
+    if (it != p && it == end) {
+      store(value, &Reflection::SetUInt64, &Reflection::AddUInt64);
+    } else if (string(p, len) == "null") {
+      do_print_null();
+    } else if (scan_json_number(p, end) == end) {
+      // such as 2.0, as if written as double
+      do_print(strtod(string(p, len).c_str(), nullptr));
+    } else {
+      mismatch();
+    }
+  }
+
+  void do_set_key(string_iterator it, string_iterator end) override
+  {
+    BOOST_ASSERT(!array_field_ && !root_);
+    if (!msg_ || *failed_) return;
+    key_.assign(it, end);
+    field_ = msg_->GetDescriptor()->FindFieldByName(key_);
+    if (!field_) { mismatch(); }
+  }
+
+  void do_flush() override {}
+
+  void do_terminate() override
+  {
+    BOOST_ASSERT(!terminated_);
+    terminated_ = true;
+    if (check_initialized_ && msg_ && !*failed_ && !msg_->IsInitialized()) {
+      mismatch();
+    }
+  }
+
+  bool do_is_terminator() const override { return terminated_; }
+
+  bool do_fail() const override { return *failed_; }
+  void do_set_failbit() override { *failed_ = true; }
+
+  shared_ptr<bool> const failed_;
+  message * const msg_;
+  FieldDescriptor const* const array_field_;
+  FieldDescriptor const* field_;
+  bool const root_;
+  bool const check_initialized_;
+  string key_;
+  bool terminated_;
+};
+
+ojstream protobuf_out(protobuf::Message & dest)
+{
+  return shared_ptr<ojsink>(make_shared<protobuf_ojnode>(dest));
+}
+
+
+} // namespace
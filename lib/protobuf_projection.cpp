@@ -0,0 +1,105 @@
+#include <jios/protobuf_projection.hpp>
+
+#include <stdexcept>
+#include <boost/assert.hpp>
+#include <boost/throw_exception.hpp>
+
+using namespace std;
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FieldMask;
+
+namespace jios {
+
+
+namespace {
+
+//! Throw std::invalid_argument unless the components of path from begin
+//! name fields of desc and its sub-messages
+void check_path(Descriptor const* desc, string const& path, size_t begin)
+{
+  while (true) {
+    size_t end = path.find('.', begin);
+    string const name = path.substr(begin, end - begin);
+    FieldDescriptor const* field = desc->FindFieldByName(name);
+    if (!field) {
+      BOOST_THROW_EXCEPTION(invalid_argument("invalid field mask path"));
+    }
+    if (end == string::npos) return;
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      BOOST_THROW_EXCEPTION(invalid_argument("invalid field mask path"));
+    }
+    desc = field->message_type();
+    begin = end + 1;
+  }
+}
+
+} // namespace
+
+int const proto_projection::none;
+int const proto_projection::all;
+
+proto_projection::proto_projection(Descriptor const* desc,
+                                   vector<string> const& paths)
+{
+  BOOST_ASSERT(desc);
+  add_node(desc);
+  for (string const& path : paths) {
+    add_path(path);
+  }
+}
+
+proto_projection::proto_projection(Descriptor const* desc,
+                                   FieldMask const& mask)
+  : proto_projection(desc, vector<string>(mask.paths().begin(),
+                                          mask.paths().end()))
+{
+}
+
+int proto_projection::add_node(Descriptor const* desc)
+{
+  nodes_.emplace_back();
+  nodes_.back().desc = desc;
+  nodes_.back().fields.assign(desc->field_count(), none);
+  return nodes_.size() - 1;
+}
+
+void proto_projection::add_path(string const& path)
+{
+  int n = 0;
+  size_t begin = 0;
+  while (true) {
+    size_t end = path.find('.', begin);
+    string const name = path.substr(begin, end - begin);
+    FieldDescriptor const* field = nodes_[n].desc->FindFieldByName(name);
+    if (!field) {
+      BOOST_THROW_EXCEPTION(invalid_argument("invalid field mask path"));
+    }
+    int & selection = nodes_[n].fields[field->index()];
+    if (selection == none && field->is_required()) {
+      nodes_[n].required.push_back(field);
+    }
+    if (end == string::npos) {
+      selection = all;
+      return;
+    }
+    if (field->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+      BOOST_THROW_EXCEPTION(invalid_argument("invalid field mask path"));
+    }
+    if (selection == all) {
+      // already selected whole, but the rest must still be valid
+      check_path(field->message_type(), path, end + 1);
+      return;
+    }
+    if (selection == none) {
+      // add_node may move nodes_, so selection is not used after it
+      int child = add_node(field->message_type());
+      nodes_[n].fields[field->index()] = child;
+    }
+    n = nodes_[n].fields[field->index()];
+    begin = end + 1;
+  }
+}
+
+
+} // namespace
@@ -0,0 +1,362 @@
+#include <jios/record_index.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <boost/core/null_deleter.hpp>
+#include <boost/throw_exception.hpp>
+#include <jios/istream_ij.hpp>
+
+using namespace std;
+
+namespace jios {
+
+
+namespace {
+
+inline bool is_ws(char ch)
+{
+  return ::isspace((unsigned char)ch);
+}
+
+void invalid_input()
+{
+  BOOST_THROW_EXCEPTION(runtime_error("invalid JSON records to index"));
+}
+
+const char sidecar_magic[8] = {'J', 'I', 'O', 'S', 'R', 'I', 'D', 'X'};
+const uint64_t sidecar_version = 1;
+
+void put_word(ostream & os, uint64_t w)
+{
+  char bytes[8];
+  for (int i = 0; i < 8; ++i) {
+    bytes[i] = char((w >> (8 * i)) & 0xFF);
+  }
+  os.write(bytes, 8);
+}
+
+bool get_word(istream & is, uint64_t & w)
+{
+  unsigned char bytes[8];
+  if (!is.read((char *)bytes, 8)) return false;
+  w = 0;
+  for (int i = 0; i < 8; ++i) {
+    w |= uint64_t(bytes[i]) << (8 * i);
+  }
+  return true;
+}
+
+//! Source of at most count values of another source
+
+class limited_ijsource : public ijsource
+{
+public:
+  limited_ijsource(shared_ptr<ijsource> const& p_src, size_t count)
+    : p_src_(p_src)
+    , remaining_(count)
+  {
+    if (!p_src_) {
+      BOOST_THROW_EXCEPTION(bad_alloc());
+    }
+  }
+
+private:
+  ijstate & do_state() override { return p_src_->state(); }
+  ijstate const& do_state() const override { return p_src_->state(); }
+
+  ijpair & do_ref() override { return p_src_->dereference(); }
+
+  bool do_is_terminator() override
+  {
+    return remaining_ == 0 || p_src_->is_terminator();
+  }
+
+  void do_advance() override
+  {
+    p_src_->advance();
+    --remaining_;
+  }
+
+  bool do_hint_multiline() const override
+  {
+    return p_src_->hint_multiline();
+  }
+
+  size_t do_size_hint() const override
+  {
+    return min(remaining_, p_src_->size_hint());
+  }
+
+  bool do_expecting() override
+  {
+    return remaining_ > 0 && p_src_->expecting();
+  }
+
+  size_t do_read_numbers(int64_t * dest, size_t n) override
+  {
+    return read_limited(dest, n);
+  }
+
+  size_t do_read_numbers(double * dest, size_t n) override
+  {
+    return read_limited(dest, n);
+  }
+
+  template<typename T>
+  size_t read_limited(T * dest, size_t n)
+  {
+    size_t count = p_src_->read_numbers(dest, min(n, remaining_));
+    remaining_ -= count;
+    return count;
+  }
+
+  shared_ptr<ijsource> p_src_;
+  size_t remaining_;
+};
+
+} // namespace
+
+// record_index
+
+record_index::record_index()
+  : array_(false)
+  , stride_(1)
+  , count_(0)
+  , end_(0)
+{
+}
+
+pair<uint64_t, size_t> record_index::locate(size_t n) const
+{
+  if (n >= count_) {
+    return make_pair(end_, size_t(0));
+  }
+  size_t k = n / stride_;
+  BOOST_ASSERT(k < offsets_.size());
+  return make_pair(offsets_[k], n - k * stride_);
+}
+
+pair<size_t, size_t> record_index::records_in(uint64_t begin,
+                                              uint64_t end) const
+{
+  auto first_at = [this](uint64_t offset) {
+    auto it = lower_bound(offsets_.begin(), offsets_.end(), offset);
+    size_t n = (it - offsets_.begin()) * stride_;
+    return min(n, count_);
+  };
+  size_t first = first_at(begin);
+  return make_pair(first, max(first, first_at(end)));
+}
+
+void record_index::save(ostream & os) const
+{
+  os.write(sidecar_magic, sizeof(sidecar_magic));
+  put_word(os, sidecar_version);
+  put_word(os, array_ ? 1 : 0);
+  put_word(os, stride_);
+  put_word(os, count_);
+  put_word(os, end_);
+  put_word(os, offsets_.size());
+  for (uint64_t offset : offsets_) {
+    put_word(os, offset);
+  }
+}
+
+void record_index::load(istream & is)
+{
+  char magic[sizeof(sidecar_magic)];
+  uint64_t version, flags, stride, count, end, n;
+  bool ok = is.read(magic, sizeof(magic))
+            && equal(magic, magic + sizeof(magic), sidecar_magic)
+            && get_word(is, version) && version == sidecar_version
+            && get_word(is, flags) && flags <= 1
+            && get_word(is, stride) && stride > 0
+            && get_word(is, count)
+            && get_word(is, end)
+            && get_word(is, n) && n == (count + stride - 1) / stride;
+  vector<uint64_t> offsets;
+  if (ok) {
+    offsets.reserve(n);
+    uint64_t offset;
+    while (offsets.size() < n && get_word(is, offset)) {
+      if (!offsets.empty() && offset <= offsets.back()) break;
+      offsets.push_back(offset);
+    }
+    ok = (offsets.size() == n);
+  }
+  if (!ok) {
+    is.setstate(ios_base::failbit);
+    return;
+  }
+  array_ = (flags == 1);
+  stride_ = stride;
+  count_ = count;
+  end_ = end;
+  offsets_.swap(offsets);
+}
+
+// index building
+
+record_index build_record_index(istream & is, size_t stride)
+{
+  if (stride == 0) {
+    BOOST_THROW_EXCEPTION(invalid_argument("record index stride of 0"));
+  }
+  record_index ret;
+  ret.stride_ = stride;
+
+  enum class phase {
+    top,           // before the first value
+    first_element, // past '[' of the top-level array
+    element,       // past ',' of the top-level array
+    value,         // scanning a record
+    delim,         // past an element of the top-level array
+    closed,        // past ']' of the top-level array
+    next           // past a value of a stream
+  };
+  phase ph = phase::top;
+  value_scanner scanner;
+  uint64_t first_offset = 0;
+
+  auto start_record = [&](uint64_t offset) {
+    if (ret.count_ % stride == 0) {
+      ret.offsets_.push_back(offset);
+    }
+    ++ret.count_;
+    scanner.reset();
+    ph = phase::value;
+  };
+
+  vector<char> buf(1 << 16);
+  uint64_t base = 0;
+  while (is) {
+    is.read(buf.data(), buf.size());
+    const char * it = buf.data();
+    const char * const end = it + is.gcount();
+    while (it != end) {
+      if (ph == phase::value) {
+        it = scanner.scan(it, end);
+        if (scanner.failed()) invalid_input();
+        if (scanner.done()) {
+          ph = (ret.array_ ? phase::delim : phase::next);
+        }
+        continue;
+      }
+      char ch = *it;
+      if (is_ws(ch)) {
+        ++it;
+        continue;
+      }
+      uint64_t offset = base + (it - buf.data());
+      switch (ph) {
+        case phase::top:
+          first_offset = offset;
+          if (ch == '[') {
+            ret.array_ = true;
+            ph = phase::first_element;
+            ++it;
+          } else {
+            start_record(offset);
+          }
+          break;
+        case phase::first_element:
+          if (ch == ']') {
+            ret.end_ = offset;
+            ph = phase::closed;
+            ++it;
+          } else {
+            start_record(offset);
+          }
+          break;
+        case phase::element:
+          start_record(offset);
+          break;
+        case phase::delim:
+          if (ch == ',') {
+            ph = phase::element;
+          } else if (ch == ']') {
+            ret.end_ = offset;
+            ph = phase::closed;
+          } else {
+            invalid_input();
+          }
+          ++it;
+          break;
+        case phase::closed:
+          // more values follow, so the array is the first record of a stream
+          ret.array_ = false;
+          ret.offsets_.assign(1, first_offset);
+          ret.count_ = 1;
+          start_record(offset);
+          break;
+        case phase::next:
+          start_record(offset);
+          break;
+        case phase::value:
+          BOOST_ASSERT(false);
+          break;
+      }
+    }
+    base += is.gcount();
+  }
+  if (ph == phase::value) {
+    scanner.finish();
+    if (scanner.failed()) invalid_input();
+    ph = (ret.array_ ? phase::delim : phase::next);
+  }
+  bool complete = (ret.array_ ? ph == phase::closed
+                              : (ph == phase::next || ph == phase::top));
+  if (!complete) {
+    invalid_input();
+  }
+  if (!ret.array_) {
+    ret.end_ = base;
+  }
+  return ret;
+}
+
+// factory functions
+
+ijstream indexed_json_in(shared_ptr<istream> const& p_is,
+                         record_index const& idx,
+                         size_t first,
+                         size_t count)
+{
+  if (!p_is) {
+    BOOST_THROW_EXCEPTION(bad_alloc());
+  }
+  pair<uint64_t, size_t> loc = idx.locate(first);
+  p_is->clear();
+  p_is->seekg(streamoff(loc.first));
+  shared_ptr<istream_facade> p_f(new istream_facade(p_is));
+  shared_ptr<istream_parser> p_p = make_split_parser(p_f);
+  shared_ptr<ijsource> p_src;
+  if (idx.array()) {
+    // the array source scans past elements it does not parse
+    p_src = make_array_tail_ijsource(p_f, p_p);
+    for (size_t i = 0; i < loc.second && !p_src->is_terminator(); ++i) {
+      p_src->advance();
+    }
+  } else {
+    for (size_t i = 0; i < loc.second && p_f->good(); ++i) {
+      skip_value(*p_f);
+    }
+    p_src = make_stream_ijsource(p_f, p_p);
+  }
+  if (count < idx.size()) {
+    p_src = make_shared<limited_ijsource>(p_src, count);
+  }
+  return ijstream(p_src);
+}
+
+ijstream indexed_json_in(istream & is,
+                         record_index const& idx,
+                         size_t first,
+                         size_t count)
+{
+  shared_ptr<istream> p_is(&is, boost::null_deleter());
+  return indexed_json_in(p_is, idx, first, count);
+}
+
+
+} // namespace
@@ -0,0 +1,210 @@
+#include <jios/tape_backend.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <boost/core/null_deleter.hpp>
+#include <boost/throw_exception.hpp>
+
+using namespace std;
+
+namespace jios {
+
+
+// tape_ojnode
+
+shared_ptr<tape_ojnode> tape_ojnode::begin_struct(tape::tag t)
+{
+  size_t start = dest_.words_.size();
+  push(t);
+  return make_shared<tape_ojnode>(dest_, start);
+}
+
+void tape_ojnode::terminate()
+{
+  BOOST_ASSERT(!terminated_);
+  if (!root_) {
+    size_t end_idx = dest_.words_.size();
+    dest_.words_.push_back(tape::make_word(tape::tag::end, count_));
+    tape::word & start = dest_.words_[start_];
+    start = tape::make_word(tape::tag_of(start), end_idx);
+  }
+  terminated_ = true;
+}
+
+// tape_value
+
+json_type tape_value::do_type() const
+{
+  switch (head_tag()) {
+    case tape::tag::null:    return json_type::jnull;
+    case tape::tag::jfalse:  return json_type::jbool;
+    case tape::tag::jtrue:   return json_type::jbool;
+    case tape::tag::integer: return json_type::jinteger;
+    case tape::tag::real:    return json_type::jfloat;
+    case tape::tag::string:  return json_type::jstring;
+    case tape::tag::array:   return json_type::jarray;
+    case tape::tag::object:  return json_type::jobject;
+    default:
+      break;
+  }
+  BOOST_ASSERT(false);
+  return json_type::jnull;
+}
+
+bool tape_value::parse(string & dest)
+{
+  const char * p = nullptr;
+  size_t len = 0;
+  string tmp;
+  if (!this->parse_text(p, len, tmp)) return mismatch();
+  dest.assign(p, p + len);
+  return true;
+}
+
+void tape_value::do_parse(buffer_iterator dest)
+{
+  const char * p = nullptr;
+  size_t len = 0;
+  string tmp;
+  if (this->parse_text(p, len, tmp)) {
+    copy(p, p + len, dest);
+  } else {
+    this->set_failbit();
+  }
+}
+
+bool tape_value::parse_text(const char * & p, size_t & len,
+                            string & tmp) const
+{
+  switch (head_tag()) {
+    case tape::tag::string:
+      p = p_tape_->arena().data() + tape::payload_of(head());
+      len = bits();
+      return true;
+    case tape::tag::integer:
+      {
+        int64_t i;
+        tape::word w = bits();
+        memcpy(&i, &w, sizeof(i));
+        tmp = to_string(i);
+      }
+      break;
+    case tape::tag::real:
+      {
+        double d;
+        tape::word w = bits();
+        memcpy(&d, &w, sizeof(d));
+        char text[32];
+        int len = snprintf(text, sizeof(text), "%.17g", d);
+        tmp.assign(text, len);
+      }
+      break;
+    case tape::tag::jtrue:
+      tmp = "true";
+      break;
+    case tape::tag::jfalse:
+      tmp = "false";
+      break;
+    default:
+      return false;
+  }
+  p = tmp.data();
+  len = tmp.size();
+  return true;
+}
+
+string tape_value::do_key() const
+{
+  boost::string_ref k = do_key_ref();
+  return string(k.begin(), k.end());
+}
+
+boost::string_ref tape_value::do_key_ref() const
+{
+  if (!has_key_) return boost::string_ref();
+  tape::word const* w = p_tape_->words().data() + key_idx_;
+  const char * p = p_tape_->arena().data() + tape::payload_of(w[0]);
+  return boost::string_ref(p, w[1]);
+}
+
+shared_ptr<tape_ijsource> tape_value::sub_source(bool object)
+{
+  tape::tag t = (object ? tape::tag::object : tape::tag::array);
+  size_t begin = 0;
+  size_t end = 0;
+  if (head_tag() != t) {
+    set_failbit();
+  } else {
+    begin = idx_ + 1;
+    end = tape::payload_of(head());
+  }
+  // reuse the previous source once no stream holds it
+  if (p_spare_ && p_spare_.use_count() == 1) {
+    p_spare_->reset(begin, end, object);
+  } else {
+    p_spare_ = make_shared<tape_ijsource>(p_state_, p_tape_, begin, end,
+                                          object);
+  }
+  return p_spare_;
+}
+
+ijarray tape_value::do_begin_array()
+{
+  return ijarray(sub_source(false));
+}
+
+ijobject tape_value::do_begin_object()
+{
+  return ijobject(sub_source(true));
+}
+
+// factory functions
+
+ojstream tape_out(tape & dest)
+{
+  return shared_ptr<ojsink>(new tape_ojnode(dest));
+}
+
+static_tape_ojstream static_tape_out(tape & dest)
+{
+  return static_tape_ojstream(make_shared<tape_ojnode>(dest));
+}
+
+shared_ptr<tape_ijsource> make_tape_ijsource(shared_ptr<tape const> const& p)
+{
+  if (!p) {
+    BOOST_THROW_EXCEPTION(invalid_argument("null tape"));
+  }
+  shared_ptr<tape_state> p_state = make_shared<tape_state>();
+  size_t end = p->words().size();
+  return make_shared<tape_ijsource>(p_state, p, 0, end, false);
+}
+
+ijstream tape_in(shared_ptr<tape const> const& p_tape)
+{
+  return ijstream(make_tape_ijsource(p_tape));
+}
+
+ijstream tape_in(tape const& src)
+{
+  return tape_in(shared_ptr<tape const>(&src, boost::null_deleter()));
+}
+
+static_tape_ijstream static_tape_in(shared_ptr<tape const> const& p_tape)
+{
+  return static_tape_ijstream(make_tape_ijsource(p_tape));
+}
+
+static_tape_ijstream static_tape_in(tape const& src)
+{
+  return static_tape_in(shared_ptr<tape const>(&src, boost::null_deleter()));
+}
+
+void jios_read(ijvalue & ij, tape & dest)
+{
+  dest.clear();
+  jios_read(ij, tape_out(dest).put());
+}
+
+
+} // namespace
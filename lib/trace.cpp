@@ -0,0 +1,120 @@
+#include <jios/trace.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace jios {
+
+
+namespace detail {
+
+thread_local trace_hook * current_trace_hook = nullptr;
+
+} // namespace detail
+
+trace_hook * set_trace_hook(trace_hook * hook)
+{
+  trace_hook * prev = detail::current_trace_hook;
+  detail::current_trace_hook = hook;
+  return prev;
+}
+
+// latency_histogram
+
+latency_histogram::latency_histogram()
+  : counts_(bucket_of(numeric_limits<uint64_t>::max()) + 1)
+  , count_(0)
+  , min_(numeric_limits<uint64_t>::max())
+  , max_(0)
+  , total_(0)
+{
+}
+
+//! Values below 2 * sub_bucket_count have a bucket each. Above, each
+//! power of two range is split into sub_bucket_count buckets.
+size_t latency_histogram::bucket_of(uint64_t value)
+{
+  if (value < 2 * sub_bucket_count) return value;
+  size_t msb = 63 - __builtin_clzll(value);
+  size_t shift = msb - sub_bucket_bits;
+  return shift * sub_bucket_count + size_t(value >> shift);
+}
+
+uint64_t latency_histogram::highest_in_bucket(size_t bucket)
+{
+  if (bucket < 2 * sub_bucket_count) return bucket;
+  size_t shift = bucket / sub_bucket_count - 1;
+  uint64_t mantissa = bucket - shift * sub_bucket_count;
+  // wraps to the maximum value for the last bucket
+  return ((mantissa + 1) << shift) - 1;
+}
+
+void latency_histogram::record(uint64_t value)
+{
+  ++counts_[bucket_of(value)];
+  ++count_;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+  total_ += value;
+}
+
+void latency_histogram::merge(latency_histogram const& other)
+{
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  min_ = std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  total_ += other.total_;
+}
+
+void latency_histogram::reset()
+{
+  fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = numeric_limits<uint64_t>::max();
+  max_ = 0;
+  total_ = 0;
+}
+
+double latency_histogram::mean() const
+{
+  return count_ ? total_ / count_ : 0;
+}
+
+uint64_t latency_histogram::value_at_percentile(double percentile) const
+{
+  if (!count_) return 0;
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t rank = uint64_t(ceil(percentile / 100 * count_));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(highest_in_bucket(i), max_);
+    }
+  }
+  return max_;
+}
+
+// histogram_trace_hook
+
+void histogram_trace_hook::reset()
+{
+  for (latency_histogram & h : histograms_) {
+    h.reset();
+  }
+}
+
+void histogram_trace_hook::record(trace_event e, chrono::nanoseconds elapsed)
+{
+  histograms_[size_t(e)].record(uint64_t(max<int64_t>(elapsed.count(), 0)));
+}
+
+
+} // namespace
@@ -0,0 +1,420 @@
+// Steady-state heap allocation checks
+//
+// Built as its own executable since it interposes malloc, calloc and
+// realloc, counting operator new and json-c's own allocations alike.
+// Each path reads or writes a stream of same-shaped records and, after
+// warm-up, counts heap allocations per record against its target.
+// Targets other than zero are regression ratchets set at the counts
+// measured when they were added, not goals: paths through json_in
+// allocate the json-c nodes of every record, about 20 to 30 each.
+// Set JIOS_ALLOC_SITES=1 to print a backtrace of each remaining
+// allocation of one record on stderr.
+
+#define BOOST_TEST_MODULE jios_alloc_test
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <execinfo.h>
+#include <unistd.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <jios/express.hpp>
+#include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
+#include <jios/protobuf_binary.hpp>
+#include <jios/protobuf_ij.hpp>
+#include <jios/protobuf_oj.hpp>
+#include <jios/tape_backend.hpp>
+
+using namespace std;
+using namespace jios;
+
+namespace {
+
+atomic<size_t> alloc_count(0);
+bool report_sites = false;
+bool in_report = false;
+
+void note_alloc()
+{
+  ++alloc_count;
+  if (report_sites && !in_report) {
+    in_report = true;
+    void * frames[12];
+    int depth = backtrace(frames, 12);
+    char const header[] = "--- allocation\n";
+    ssize_t ignored = write(STDERR_FILENO, header, sizeof(header) - 1);
+    (void)ignored;
+    backtrace_symbols_fd(frames + 1, depth - 1, STDERR_FILENO);
+    in_report = false;
+  }
+}
+
+} // namespace
+
+// glibc's allocator entry points, wrapped by the definitions below
+extern "C" {
+void * __libc_malloc(size_t n);
+void * __libc_calloc(size_t n, size_t size);
+void * __libc_realloc(void * p, size_t n);
+
+void * malloc(size_t n) noexcept
+{
+  note_alloc();
+  return __libc_malloc(n);
+}
+
+void * calloc(size_t n, size_t size) noexcept
+{
+  note_alloc();
+  return __libc_calloc(n, size);
+}
+
+void * realloc(void * p, size_t n) noexcept
+{
+  note_alloc();
+  return __libc_realloc(p, n);
+}
+}
+
+namespace {
+
+//! ostream discarding output
+class null_streambuf : public streambuf
+{
+protected:
+  int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+  streamsize xsputn(char const*, streamsize n) override { return n; }
+};
+
+size_t const warmup_records = 16;
+size_t const measured_records = 64;
+size_t const total_records = warmup_records + measured_records + 1;
+
+//! Average heap allocations per call of record after warm-up
+double allocs_per_record(char const* path, function<void()> const& record)
+{
+  for (size_t i = 0; i < warmup_records; ++i) {
+    record();
+  }
+  size_t start = alloc_count;
+  for (size_t i = 0; i < measured_records; ++i) {
+    record();
+  }
+  double ret = double(alloc_count - start) / measured_records;
+  BOOST_TEST_MESSAGE(path << ": " << ret << " allocations per record");
+  if (getenv("JIOS_ALLOC_SITES") && ret > 0) {
+    cerr << "=== " << path << '\n';
+    report_sites = true;
+    record();
+    report_sites = false;
+  }
+  return ret;
+}
+
+struct record
+  : private jobject_expressible<record>
+{
+  int64_t id;
+  string name;
+  double score;
+  bool active;
+  vector<int64_t> counts;
+
+  template<class Expression>
+  static void jios_express(Expression & exp)
+  {
+    exp.member("id", &record::id)
+       .member("name", &record::name)
+       .member("score", &record::score)
+       .member("active", &record::active)
+       .member("counts", &record::counts);
+  }
+};
+
+record sample_record()
+{
+  record ret;
+  ret.id = 12345;
+  ret.name = "a record name beyond small string size";
+  ret.score = 0.25;
+  ret.active = true;
+  ret.counts = {1, 2, 3, 4};
+  return ret;
+}
+
+//! Record with a vector of strings, for updating in place
+struct labeled_record
+  : private jobject_expressible<labeled_record>
+{
+  int64_t id;
+  string name;
+  vector<int64_t> counts;
+  vector<string> labels;
+
+  template<class Expression>
+  static void jios_express(Expression & exp)
+  {
+    exp.member("id", &labeled_record::id)
+       .member("name", &labeled_record::name)
+       .member("counts", &labeled_record::counts)
+       .member("labels", &labeled_record::labels);
+  }
+};
+
+labeled_record sample_labeled_record()
+{
+  labeled_record ret;
+  ret.id = 12345;
+  ret.name = "a record name beyond small string size";
+  ret.counts = {1, 2, 3, 4};
+  ret.labels = {"a first label beyond small string size",
+                "a second label beyond small string size"};
+  return ret;
+}
+
+template<class Record>
+string record_text(bool array, Record const& r)
+{
+  ostringstream os;
+  ojstream out = (array ? json_out(os) : lined_json_out(os));
+  if (array) {
+    ojarray oja = out.put().array();
+    for (size_t i = 0; i < total_records; ++i) { oja << r; }
+    oja.terminate();
+  } else {
+    for (size_t i = 0; i < total_records; ++i) { out << r; }
+  }
+  out.put().flush();
+  return os.str();
+}
+
+string record_text(bool array)
+{
+  return record_text(array, sample_record());
+}
+
+typedef google::protobuf::FieldDescriptorProto proto_record;
+
+proto_record sample_proto()
+{
+  proto_record ret;
+  ret.set_name("a field name beyond small string size");
+  ret.set_number(7);
+  ret.set_type_name(".some.package.SomeType");
+  ret.set_json_name("aFieldName");
+  ret.set_proto3_optional(true);
+  return ret;
+}
+
+} // namespace
+
+// Lower targets as paths stop allocating. The tape express reads
+// allocate only the vector storage released by clearing.
+
+BOOST_AUTO_TEST_CASE( json_in_array_express_allocs )
+{
+  istringstream ss(record_text(true));
+  ijarray ija = json_in(ss).get().array();
+  record r;
+  double n = allocs_per_record("json_in array express", [&]() {
+    ija >> r;
+  });
+  BOOST_CHECK( !ija.fail() );
+  BOOST_CHECK_EQUAL( r.counts.size(), 4 );
+  BOOST_CHECK_LE( n, 32 );
+}
+
+BOOST_AUTO_TEST_CASE( json_in_ndjson_express_allocs )
+{
+  istringstream ss(record_text(false));
+  ijstream jin = json_in(ss);
+  record r;
+  double n = allocs_per_record("json_in NDJSON express", [&]() {
+    jin >> r;
+  });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( r.name, sample_record().name );
+  BOOST_CHECK_LE( n, 32 );
+}
+
+BOOST_AUTO_TEST_CASE( tape_in_express_allocs )
+{
+  tape t;
+  {
+    ojstream out = tape_out(t);
+    for (size_t i = 0; i < total_records; ++i) { out << sample_record(); }
+  }
+  ijstream jin = tape_in(t);
+  record r;
+  double n = allocs_per_record("tape_in express", [&]() { jin >> r; });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_LE( n, 1 );
+
+  static_tape_ijstream sjin = static_tape_in(t);
+  n = allocs_per_record("static_tape_in express", [&]() { sjin >> r; });
+  BOOST_CHECK_LE( n, 1 );
+}
+
+// With jios_update, members keep their capacity. The tape back-end
+// reuses its sources, leaving no allocations.
+
+BOOST_AUTO_TEST_CASE( json_in_update_allocs )
+{
+  labeled_record const sample = sample_labeled_record();
+  istringstream ss(record_text(true, sample));
+  ijarray ija = json_in(ss).get().array();
+  labeled_record r;
+  double n = allocs_per_record("json_in array update", [&]() {
+    jios_update(ija.get(), r);
+  });
+  BOOST_CHECK( !ija.fail() );
+  BOOST_CHECK_EQUAL( r.labels.size(), 2 );
+  BOOST_CHECK_LE( n, 33 );
+
+  istringstream ndjson(record_text(false, sample));
+  ijstream jin = json_in(ndjson);
+  n = allocs_per_record("json_in NDJSON update", [&]() {
+    jios_update(jin.get(), r);
+  });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_LE( n, 33 );
+}
+
+BOOST_AUTO_TEST_CASE( tape_in_update_allocs )
+{
+  tape t;
+  {
+    ojstream out = tape_out(t);
+    for (size_t i = 0; i < total_records; ++i) {
+      out << sample_labeled_record();
+    }
+  }
+  ijstream jin = tape_in(t);
+  labeled_record r;
+  double n = allocs_per_record("tape_in update", [&]() {
+    jios_update(jin.get(), r);
+  });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( r.labels.size(), 2 );
+  BOOST_CHECK_EQUAL( n, 0 );
+}
+
+BOOST_AUTO_TEST_CASE( lined_json_out_express_allocs )
+{
+  null_streambuf buf;
+  ostream os(&buf);
+  ojstream out = lined_json_out(os);
+  record const r = sample_record();
+  double n = allocs_per_record("lined_json_out express", [&]() {
+    out << r;
+  });
+  BOOST_CHECK( os.good() );
+  BOOST_CHECK_LE( n, 3 );
+}
+
+BOOST_AUTO_TEST_CASE( tape_out_express_allocs )
+{
+  tape t;
+  ojstream out = tape_out(t);
+  record const r = sample_record();
+  // tape growth is amortized rather than steady, so write into a
+  // tape whose capacity was reached during warm-up
+  for (size_t i = 0; i < total_records; ++i) { out << r; }
+  double n = allocs_per_record("tape_out express", [&]() {
+    t.clear();
+    ojstream reused = tape_out(t);
+    reused << r;
+  });
+  BOOST_CHECK_LE( n, 7 );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_allocs )
+{
+  ostringstream os;
+  {
+    ojstream out = lined_json_out(os);
+    for (size_t i = 0; i < total_records; ++i) { out << sample_proto(); }
+    out.put().flush();
+  }
+  istringstream ss(os.str());
+  ijstream jin = json_in(ss);
+  proto_record pro;
+  double n = allocs_per_record("json_in protobuf", [&]() { jin >> pro; });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( pro.number(), 7 );
+  BOOST_CHECK_LE( n, 24 );
+
+  null_streambuf buf;
+  ostream null_os(&buf);
+  ojstream out = lined_json_out(null_os);
+  n = allocs_per_record("lined_json_out protobuf", [&]() { out << pro; });
+  BOOST_CHECK_LE( n, 4 );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_arena_allocs )
+{
+  size_t const batch_size = 8;
+  proto_record nested = sample_proto();
+  nested.mutable_options()->set_deprecated(true);
+  ostringstream os;
+  {
+    ojstream out = lined_json_out(os);
+    for (size_t i = 0; i < total_records * batch_size; ++i) {
+      out << nested;
+    }
+    out.put().flush();
+  }
+  istringstream ss(os.str());
+  ijstream jin = json_in(ss);
+  proto_arena arena;
+  vector<proto_record *> batch;
+  double n = allocs_per_record("json_in protobuf arena batch", [&]() {
+    read_batch(jin, arena, batch, batch_size);
+  }) / batch_size;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( batch.size(), batch_size );
+  BOOST_CHECK( batch.back()->options().deprecated() );
+  BOOST_TEST_MESSAGE("json_in protobuf arena: " << n
+                     << " allocations per message");
+  // sub-messages and strings are on the arena, leaving json-c's
+  // nodes, the back-end sources and the string being parsed
+  BOOST_CHECK_LE( n, 33 );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_binary_allocs )
+{
+  ostringstream os;
+  ostringstream binary;
+  {
+    ojstream out = lined_json_out(os);
+    for (size_t i = 0; i < total_records; ++i) {
+      out << sample_proto();
+      google::protobuf::util::SerializeDelimitedToOstream(sample_proto(),
+                                                          &binary);
+    }
+    out.put().flush();
+  }
+  istringstream ss(os.str());
+  ijstream jin = json_in(ss);
+  proto_encoder encoder(proto_record::descriptor());
+  double n = allocs_per_record("json_in protobuf binary encode", [&]() {
+    encoder.encode(jin.get());
+  });
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_LE( n, 22 );
+
+  istringstream bs(binary.str());
+  ijstream bin = protobuf_delimited_in(bs, proto_record::descriptor());
+  null_streambuf buf;
+  ostream null_os(&buf);
+  ojstream out = lined_json_out(null_os);
+  n = allocs_per_record("protobuf_delimited_in to lined_json_out", [&]() {
+    jios_read(bin.get(), out.put());
+  });
+  BOOST_CHECK( !bin.fail() );
+  BOOST_CHECK_LE( n, 5 );
+}
@@ -0,0 +1,126 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/columnar.hpp>
+#include <jios/express.hpp>
+#include <jios/json_in.hpp>
+
+using namespace std;
+using namespace jios;
+
+struct trade
+  : private jobject_expressible<trade>
+{
+  int64_t id;
+  string symbol;
+  double price;
+  vector<string> tags;
+
+  template<class Expression>
+  static void jios_express(Expression & exp)
+  {
+    exp.member("id", &trade::id)
+       .member("symbol", &trade::symbol)
+       .member("price", &trade::price)
+       .member("tags", &trade::tags);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( columnar_express_test )
+{
+  column_table table;
+  ojstream out = columnar_out(table);
+  for (int i = 0; i < 4; ++i) {
+    trade t;
+    t.id = i;
+    t.symbol = (i % 2 ? "ABC" : "XYZ");
+    t.price = 1.5 * i;
+    t.tags.assign(i, "t");
+    out << t;
+  }
+  BOOST_CHECK( !out.fail() );
+  BOOST_REQUIRE_EQUAL( table.size(), 4 );
+  BOOST_CHECK_EQUAL( table.columns().size(), 5 );
+
+  column const* id = table.find("id");
+  BOOST_REQUIRE( id );
+  BOOST_CHECK( id->type() == json_type::jinteger );
+  BOOST_CHECK( id->integers() == vector<int64_t>({0, 1, 2, 3}) );
+  vector<double> prices = {0, 1.5, 3, 4.5};
+  BOOST_CHECK( table.find("price")->reals() == prices );
+
+  column const* symbol = table.find("symbol");
+  BOOST_CHECK( symbol->dictionary_encoded() );
+  BOOST_CHECK( symbol->codes() == vector<uint32_t>({0, 1, 0, 1}) );
+  BOOST_CHECK_EQUAL( symbol->bytes(), "XYZABC" );
+  BOOST_CHECK_EQUAL( symbol->string_at(3), "ABC" );
+
+  column const* tags = table.find("tags");
+  BOOST_CHECK( tags->type() == json_type::jarray );
+  BOOST_CHECK( tags->offsets() == vector<uint64_t>({0, 0, 1, 3, 6}) );
+  BOOST_CHECK_EQUAL( table.find("tags[]")->size(), 6 );
+}
+
+BOOST_AUTO_TEST_CASE( read_columns_test )
+{
+  istringstream ss(R"(
+    {"a": 1, "b": {"c": "x"}, "items": [{"p": 1}, {"q": true}]}
+    {"a": 2.5, "items": null}
+    {"b": {"c": null}, "items": [{"p": 3}]}
+  )");
+  ijstream jin = json_in(ss);
+  column_table table;
+  BOOST_CHECK_EQUAL( read_columns(jin, table), 3 );
+  BOOST_CHECK( !table.fail() );
+
+  column const* a = table.find("a");
+  BOOST_CHECK( a->type() == json_type::jfloat );
+  BOOST_CHECK( a->reals() == vector<double>({1, 2.5, 0}) );
+  BOOST_CHECK( a->valid(1) );
+  BOOST_CHECK( !a->valid(2) );
+
+  column const* c = table.find("b.c");
+  BOOST_CHECK_EQUAL( c->size(), 3 );
+  BOOST_CHECK( c->valid(0) && !c->valid(1) && !c->valid(2) );
+
+  column const* items = table.find("items");
+  BOOST_CHECK( items->offsets() == vector<uint64_t>({0, 2, 2, 3}) );
+  BOOST_CHECK( !items->valid(1) );
+  column const* p = table.find("items[].p");
+  BOOST_CHECK( p->integers() == vector<int64_t>({1, 0, 3}) );
+  BOOST_CHECK( !p->valid(1) );
+  column const* q = table.find("items[].q");
+  BOOST_CHECK( q->type() == json_type::jbool );
+  BOOST_CHECK_EQUAL( q->size(), 3 );
+  BOOST_CHECK( q->valid(1) && !q->valid(2) );
+}
+
+BOOST_AUTO_TEST_CASE( columnar_dictionary_limit_test )
+{
+  column_table table(2);
+  ojstream out = columnar_out(table);
+  out << "a" << "b" << "a" << nullptr << "c";
+  column const* col = table.find("");
+  BOOST_REQUIRE( col );
+  BOOST_CHECK( !col->dictionary_encoded() );
+  BOOST_CHECK_EQUAL( col->bytes(), "abac" );
+  BOOST_CHECK( col->offsets() == vector<uint64_t>({0, 1, 2, 3, 3, 4}) );
+  BOOST_CHECK_EQUAL( col->string_at(2), "a" );
+  BOOST_CHECK( !col->valid(3) );
+}
+
+BOOST_AUTO_TEST_CASE( columnar_conflict_test )
+{
+  column_table table;
+  ojstream out = columnar_out(table);
+  out << 1 << true;
+  BOOST_CHECK( out.fail() );
+  BOOST_CHECK_EQUAL( table.size(), 1 );
+
+  table.clear();
+  BOOST_CHECK( !table.fail() );
+  ojstream again = columnar_out(table);
+  ojobject ojo = again.put().object();
+  ojo << make_pair("a", 1) << make_pair("a", 2);
+  ojo.terminate();
+  BOOST_CHECK( table.fail() );
+}
@@ -0,0 +1,135 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/compress.hpp>
+#include <jios/json_in.hpp>
+
+using namespace std;
+using namespace jios;
+
+int const record_count = 30000;
+
+string compressed_records(compression c, unsigned threads)
+{
+  ostringstream os;
+  {
+    ojstream jout = compressed_lined_json_out(os, c, threads);
+    for (int i = 0; i < record_count; ++i) {
+      ojobject ojo = jout.put().object();
+      ojo << make_pair("id", i)
+          << make_pair("name", "record " + to_string(i));
+      ojo.terminate();
+    }
+  }
+  return os.str();
+}
+
+void check_records(string const& data)
+{
+  istringstream ss(data);
+  ijstream jin = compressed_json_in(ss);
+  int i = 0;
+  while (!jin.at_end()) {
+    map<string, string> m;
+    jin >> m;
+    if (m["id"] != to_string(i)) break;
+    ++i;
+  }
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( i, record_count );
+}
+
+BOOST_AUTO_TEST_CASE( gzip_roundtrip_test )
+{
+  string data = compressed_records(compression::gzip, 1);
+  BOOST_CHECK_EQUAL( (unsigned char)data[0], 0x1f );
+  check_records(data);
+}
+
+BOOST_AUTO_TEST_CASE( parallel_gzip_roundtrip_test )
+{
+  string data = compressed_records(compression::gzip, 4);
+  BOOST_CHECK_EQUAL( (unsigned char)data[0], 0x1f );
+  check_records(data);
+}
+
+BOOST_AUTO_TEST_CASE( zstd_roundtrip_test )
+{
+  if (compression_supported(compression::zstd)) {
+    check_records(compressed_records(compression::zstd, 1));
+    check_records(compressed_records(compression::zstd, 4));
+  } else {
+    ostringstream os;
+    BOOST_CHECK_THROW( compressed_ostream(os, compression::zstd),
+                       invalid_argument );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( uncompressed_passthrough_test )
+{
+  istringstream ss("[1, 2] 3");
+  vector<int> v;
+  int i;
+  ijstream jin = compressed_json_in(ss);
+  jin >> v >> i;
+  BOOST_CHECK_EQUAL( v.size(), 2 );
+  BOOST_CHECK_EQUAL( i, 3 );
+  BOOST_CHECK( jin.at_end() );
+}
+
+BOOST_AUTO_TEST_CASE( truncated_gzip_test )
+{
+  string data = compressed_records(compression::gzip, 1);
+  istringstream ss(data.substr(0, data.size() / 2));
+  ijstream jin = compressed_json_in(ss);
+  int count = 0;
+  while (!jin.at_end() && !jin.fail()) {
+    map<string, string> m;
+    jin >> m;
+    ++count;
+  }
+  BOOST_CHECK( jin.fail() );
+  BOOST_CHECK( count < record_count );
+}
+
+struct rejecting_buf : streambuf {};
+
+BOOST_AUTO_TEST_CASE( compressed_write_error_test )
+{
+  rejecting_buf buf;
+  ostream target(&buf);
+  shared_ptr<ostream> p_os = compressed_ostream(target);
+  *p_os << "[1, 2, 3]";
+  BOOST_CHECK( p_os->good() );
+  finish_compressed(*p_os);
+  BOOST_CHECK( p_os->bad() );
+  BOOST_CHECK( target.bad() );
+}
+
+BOOST_AUTO_TEST_CASE( compressed_write_error_on_destroy_test )
+{
+  rejecting_buf buf;
+  ostream target(&buf);
+  {
+    ojstream jout = compressed_lined_json_out(target, compression::gzip, 4);
+    jout << 1 << 2;
+  }
+  BOOST_CHECK( target.bad() );
+}
+
+BOOST_AUTO_TEST_CASE( finish_compressed_test )
+{
+  ostringstream os;
+  shared_ptr<ostream> p_os = compressed_ostream(os);
+  *p_os << "[1, 2, 3]";
+  finish_compressed(*p_os);
+  BOOST_CHECK( p_os->good() );
+  string data = os.str();
+  BOOST_CHECK_EQUAL( (unsigned char)data[0], 0x1f );
+  p_os.reset();
+  BOOST_CHECK_EQUAL( os.str(), data );
+  istringstream ss(data);
+  vector<int> v;
+  compressed_json_in(ss) >> v;
+  BOOST_CHECK( (v == vector<int>{1, 2, 3}) );
+  BOOST_CHECK_THROW( finish_compressed(os), invalid_argument );
+}
@@ -83,3 +83,271 @@ BOOST_AUTO_TEST_CASE( express_map_in_test )
   BOOST_CHECK_EQUAL( ids[9943].age, 32 );
 }
 
+
+struct compiled_person
+  : private jios::jobject_compiled_expressible<compiled_person>
+{
+  string name;
+  int age;
+  vector<person> friends;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("name", &compiled_person::name)
+       .member("age", &compiled_person::age)
+       .member("friends", &compiled_person::friends);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( express_compiled_test )
+{
+  stringstream ss;
+  ss << R"( { "age":32, "friends":[{"name":"Jane", "age":33}], )"
+     << R"(   "name":"Joe" } )";
+  ss << R"( { "name":"Bob", "height":180 } )";
+  compiled_person joe;
+  ijstream jin = json_in(ss);
+  jin >> joe;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( joe.name, "Joe" );
+  BOOST_CHECK_EQUAL( joe.age, 32 );
+  BOOST_REQUIRE_EQUAL( joe.friends.size(), 1 );
+  BOOST_CHECK_EQUAL( joe.friends[0].name, "Jane" );
+
+  ostringstream os;
+  lined_json_out(os) << joe;
+  BOOST_CHECK_EQUAL( os.str(), R"({"name":"Joe","age":32,)"
+                               R"("friends":[{"name":"Jane","age":33}]})"
+                               "\n" );
+  jin >> joe;
+  BOOST_CHECK( jin.fail() );
+
+  // same length and first byte as "name"
+  istringstream near(R"({"nome":"Joe"})");
+  ijstream jin2 = json_in(near);
+  jin2 >> joe;
+  BOOST_CHECK( jin2.fail() );
+}
+
+struct team
+  : private jios::jobject_expressible<team>
+{
+  string name;
+  vector<person> members;
+  map<string, int> scores;
+  boost::optional<person> lead;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("name", &team::name)
+       .member("members", &team::members)
+       .member("scores", &team::scores)
+       .member("lead", &team::lead);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( express_update_test )
+{
+  stringstream ss;
+  ss << R"( {"name":"a team name longer than short strings",)"
+     << R"(  "members":[{"name":"a member name longer than short", "age":1},)"
+     << R"(             {"name":"Jim", "age":2}],)"
+     << R"(  "scores":{"a":1, "b":2, "c":3}, "lead":{"name":"Al", "age":3}} )"
+     << R"( {"members":[{"name":"Kim", "age":4}],)"
+     << R"(  "scores":{"a":4, "c":5, "d":6}} )"
+     << R"( {"scores":{"d":7, "a":8}} )"
+     << R"( {"name":"x", "unknown":1} )";
+  ijstream jin = json_in(ss);
+  team t;
+  BOOST_CHECK( jios_update(jin.get(), t) );
+  BOOST_CHECK_EQUAL( t.members.size(), 2 );
+  BOOST_CHECK( t.lead );
+  char const* name_data = t.name.data();
+  string const& member_name = t.members[0].name;
+  char const* member_data = member_name.data();
+  map<string, int>::iterator a_node = t.scores.find("a");
+
+  BOOST_CHECK( jios_update(jin.get(), t) );
+  BOOST_CHECK( t.name.empty() );
+  BOOST_CHECK_EQUAL( t.name.data(), name_data );
+  BOOST_REQUIRE_EQUAL( t.members.size(), 1 );
+  BOOST_CHECK_EQUAL( t.members[0].name, "Kim" );
+  BOOST_CHECK_EQUAL( t.members[0].age, 4 );
+  BOOST_CHECK_EQUAL( t.members[0].name.data(), member_data );
+  map<string, int> scores = {{"a", 4}, {"c", 5}, {"d", 6}};
+  BOOST_CHECK( t.scores == scores );
+  BOOST_CHECK( t.scores.find("a") == a_node );
+  BOOST_CHECK( !t.lead );
+
+  BOOST_CHECK( jios_update(jin.get(), t) );
+  BOOST_CHECK( t.members.empty() );
+  scores = {{"a", 8}, {"d", 7}};
+  BOOST_CHECK( t.scores == scores );
+
+  BOOST_CHECK( !jios_update(jin.get(), t) );
+}
+
+struct point
+{
+  int x;
+  int y;
+  string label;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member(&point::x)
+       .member(&point::y)
+       .member(&point::label);
+  }
+
+  friend void jios_read(ijvalue & ij, point & dest)
+  {
+    jtuple_reader<point>::read(ij, dest);
+  }
+
+  friend void jios_write(ojvalue & oj, point const& src)
+  {
+    jtuple_writer<point>::write(oj, src);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( express_tuple_test )
+{
+  stringstream ss;
+  ss << R"( [1, 2, "a"] [1, 2] )";
+  ijstream jin = json_in(ss);
+  point p;
+  BOOST_CHECK( jin.get().read(p) );
+  BOOST_CHECK_EQUAL( p.y, 2 );
+  BOOST_CHECK_EQUAL( p.label, "a" );
+  ostringstream os;
+  lined_json_out(os) << p;
+  BOOST_CHECK_EQUAL( os.str(), "[1,2,\"a\"]\n" );
+  BOOST_CHECK( !jin.get().read(p) );
+}
+
+BOOST_AUTO_TEST_CASE( express_tuple_too_long_test )
+{
+  istringstream ss("[1, 2, \"a\", 4]");
+  point p;
+  BOOST_CHECK( !json_in(ss).get().read(p) );
+}
+
+struct sparse_record
+  : private jios::jobject_sparse_expressible<sparse_record>
+{
+  int id = 0;
+  string name;
+  boost::optional<double> score;
+  vector<int> counts;
+  person owner = person();
+  bool flag = false;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("id", &sparse_record::id)
+       .member("name", &sparse_record::name)
+       .member("score", &sparse_record::score)
+       .member("counts", &sparse_record::counts)
+       .member("owner", &sparse_record::owner)
+       .member("flag", &sparse_record::flag);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( express_sparse_test )
+{
+  sparse_record r;
+  ostringstream os;
+  lined_json_out(os) << r;
+  BOOST_CHECK_EQUAL( os.str(), "{}\n" );
+
+  r.id = 3;
+  r.score = 0.0;
+  r.owner.age = 30;
+  os.str("");
+  lined_json_out(os) << r;
+  BOOST_CHECK_EQUAL( os.str(), R"({"id":3,"score":0,"owner":{"age":30}})"
+                               "\n" );
+
+  istringstream is(os.str());
+  sparse_record back;
+  back.name = "old";
+  json_in(is) >> back;
+  BOOST_CHECK_EQUAL( back.id, 3 );
+  BOOST_CHECK( back.name.empty() );
+  BOOST_CHECK( back.score && *back.score == 0 );
+  BOOST_CHECK_EQUAL( back.owner.age, 30 );
+
+  person joe;
+  joe.age = 0;
+  joe.name = "Joe";
+  os.str("");
+  lined_json_out(os) << sparse(joe) << joe;
+  BOOST_CHECK_EQUAL( os.str(), "{\"name\":\"Joe\"}\n"
+                               "{\"name\":\"Joe\",\"age\":0}\n" );
+}
+
+struct sparse_shape
+  : private jios::jobject_sparse_expressible<sparse_shape>
+{
+  int id = 0;
+  point corner = point();
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("id", &sparse_shape::id)
+       .member("corner", &sparse_shape::corner);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( express_sparse_tuple_member_test )
+{
+  sparse_shape s;
+  ostringstream os;
+  lined_json_out(os) << s;
+  BOOST_CHECK_EQUAL( os.str(), "{\"corner\":[0,0,\"\"]}\n" );
+  s.id = 2;
+  s.corner.x = 5;
+  os.str("");
+  lined_json_out(os) << s;
+  BOOST_CHECK_EQUAL( os.str(), "{\"id\":2,\"corner\":[5,0,\"\"]}\n" );
+}
+
+struct placed_point
+  : private jios::jobject_expressible<placed_point>
+{
+  string name;
+  point at;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("name", &placed_point::name)
+       .member("at", &placed_point::at);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( update_tuple_member_test )
+{
+  istringstream ss(R"({"name":"a", "at":[1, 2, "b"]} {"name":"c"})");
+  ijstream jin = json_in(ss);
+  placed_point p;
+  BOOST_CHECK( jios_update(jin.get(), p) );
+  BOOST_CHECK_EQUAL( p.at.y, 2 );
+  BOOST_CHECK_EQUAL( p.at.label, "b" );
+  BOOST_CHECK( jios_update(jin.get(), p) );
+  BOOST_CHECK_EQUAL( p.name, "c" );
+  BOOST_CHECK_EQUAL( p.at.x, 0 );
+  BOOST_CHECK( p.at.label.empty() );
+}
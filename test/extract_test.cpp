@@ -0,0 +1,104 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/extract.hpp>
+#include <jios/json_in.hpp>
+
+using namespace std;
+using namespace jios;
+
+BOOST_AUTO_TEST_CASE( extract_test )
+{
+  istringstream ss(R"(
+    {"user":{"id":7, "name":"Joe", "tags":["a", "b"]},
+     "events":[{"ts":1, "data":[1, [2, 3]]}, {"data":{}, "ts":2}],
+     "junk":{"ts":3},
+     "a/b":{"~":"tilde"}}
+  )");
+  int id = 0;
+  string tag, tilde;
+  vector<int> stamps;
+  path_extractor ex;
+  ex.bind("/user/id", id)
+    .bind("/user/tags/1", tag)
+    .bind("/a~1b/~0", tilde)
+    .bind("/events/*/ts", [&stamps](ijvalue & ij) {
+      int ts;
+      if (ij.read(ts)) { stamps.push_back(ts); }
+    });
+  ijstream jin = json_in(ss);
+  ex.extract(jin.get());
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( id, 7 );
+  BOOST_CHECK_EQUAL( tag, "b" );
+  BOOST_CHECK_EQUAL( tilde, "tilde" );
+  BOOST_REQUIRE_EQUAL( stamps.size(), 2 );
+  BOOST_CHECK_EQUAL( stamps[0], 1 );
+  BOOST_CHECK_EQUAL( stamps[1], 2 );
+}
+
+BOOST_AUTO_TEST_CASE( extract_stream_test )
+{
+  istringstream ss(R"([[0, [9, 9]], [1, {"x":1}], [2, "skip"]] 5)");
+  vector<int> firsts;
+  path_extractor ex;
+  ex.bind("/*/0", [&firsts](ijvalue & ij) {
+    int i;
+    if (ij.read(i)) { firsts.push_back(i); }
+  });
+  ijstream jin = json_in(ss);
+  ex.extract(jin.get());
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK( firsts == vector<int>({0, 1, 2}) );
+  int i;
+  jin >> i;
+  BOOST_CHECK_EQUAL( i, 5 );
+
+  BOOST_CHECK_THROW( path_extractor().bind("x", i), invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( extract_overlap_test )
+{
+  istringstream ss(R"(
+    {"events":[{"ts":1, "id":"x"}, {"ts":2, "id":"y"}],
+     "a":{"b":3}}
+  )");
+  vector<int> stamps;
+  string id;
+  map<string, int> a;
+  int b = 0;
+  path_extractor ex;
+  ex.bind("/events/*/ts", [&stamps](ijvalue & ij) {
+      int ts;
+      if (ij.read(ts)) { stamps.push_back(ts); }
+    })
+    .bind("/events/0/id", id)
+    .bind("/a", a)
+    .bind("/a/b", b);
+  ijstream jin = json_in(ss);
+  ex.extract(jin.get());
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK( stamps == vector<int>({1, 2}) );
+  BOOST_CHECK_EQUAL( id, "x" );
+  BOOST_CHECK_EQUAL( a["b"], 3 );
+  BOOST_CHECK_EQUAL( b, 3 );
+}
+
+BOOST_AUTO_TEST_CASE( extract_stream_overlap_test )
+{
+  istringstream ss(R"([[0, 7], [1, 8]])");
+  vector<int> firsts, seconds;
+  path_extractor ex;
+  ex.bind("/*/0", [&firsts](ijvalue & ij) {
+      int i;
+      if (ij.read(i)) { firsts.push_back(i); }
+    })
+    .bind("/1/1", [&seconds](ijvalue & ij) {
+      int i;
+      if (ij.read(i)) { seconds.push_back(i); }
+    });
+  ijstream jin = json_in(ss);
+  ex.extract(jin.get());
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK( firsts == vector<int>({0, 1}) );
+  BOOST_CHECK( seconds == vector<int>({8}) );
+}
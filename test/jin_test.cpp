@@ -1,6 +1,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 using namespace std;
@@ -388,3 +389,252 @@ BOOST_AUTO_TEST_CASE( nested_array_test )
   BOOST_CHECK( !ija.fail() );
 }
 
+
+BOOST_AUTO_TEST_CASE( skip_test )
+{
+  stringstream ss;
+  ss << R"([ {"a":"}]\"", "b":[1, {"c":2}]}, [[1], "]", 2], "x\"]", 3, )"
+     << R"( 4.5e3, [], [5, [6]], true, 7 ] 8)";
+  ijstream jin = json_in(ss);
+  ijarray ija = jin.get().array();
+  ija.skip();
+  ija.skip();
+  ija.skip();
+  int i;
+  ija >> i;
+  BOOST_CHECK_EQUAL( i, 3 );
+  ija.skip();
+  ija.get().skip();
+  ijarray ija2 = ija.get().array();
+  ija2 >> i;
+  BOOST_CHECK_EQUAL( i, 5 );
+  ija.skip();
+  ija >> i;
+  BOOST_CHECK_EQUAL( i, 7 );
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( !ija.fail() );
+  jin >> i;
+  BOOST_CHECK_EQUAL( i, 8 );
+  BOOST_CHECK( !ss.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( skip_unread_nested_array_test )
+{
+  istringstream ss("[[1, [2]], [3], [4, 5], 6]");
+  vector<int> v;
+  ijstream jin = json_in(ss);
+  ijarray ija = jin.get().array();
+  ija.get();
+  ija.get().array();
+  ija >> v;
+  BOOST_CHECK_EQUAL( v.size(), 2 );
+  int i;
+  ija >> i;
+  BOOST_CHECK_EQUAL( i, 6 );
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( !ija.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( skip_bad_test )
+{
+  istringstream ss("[1, ]");
+  ijstream jin = json_in(ss);
+  ijarray ija = jin.get().array();
+  ija.skip();
+  ija.skip();
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( ija.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( parse_containers_test )
+{
+  istringstream ss(R"([1, 2, 3] [1, 2, 3] [3, 1, 3] ["a", "b"] )"
+                   R"({"a":1, "b":2} [[1, 2], [3]])");
+  ijstream jin = json_in(ss);
+  array<int, 3> a;
+  forward_list<int> fl;
+  set<int> s;
+  unordered_set<string> us;
+  unordered_map<string, int> um;
+  vector<vector<int>> vv;
+  jin >> a >> fl >> s >> us >> um >> vv;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK( (a == array<int, 3>{{1, 2, 3}}) );
+  BOOST_CHECK( (fl == forward_list<int>{1, 2, 3}) );
+  BOOST_CHECK( (s == set<int>{1, 3}) );
+  BOOST_CHECK( (us == unordered_set<string>{"a", "b"}) );
+  BOOST_CHECK_EQUAL( um.size(), 2 );
+  BOOST_CHECK_EQUAL( um["b"], 2 );
+  BOOST_CHECK( (vv == vector<vector<int>>{{1, 2}, {3}}) );
+}
+
+BOOST_AUTO_TEST_CASE( parse_wrong_size_array_test )
+{
+  array<int, 3> a;
+  istringstream ss1("[1, 2]");
+  BOOST_CHECK( json_in(ss1).get().read(a) == false );
+  istringstream ss2("[1, 2, 3, 4]");
+  BOOST_CHECK( json_in(ss2).get().read(a) == false );
+}
+
+BOOST_AUTO_TEST_CASE( read_numbers_test )
+{
+  ostringstream os;
+  os << "[";
+  for (int i = 0; i < 10000; ++i) {
+    os << (i ? ", " : "") << (i % 2 ? -i : i) << (i % 3 ? "" : ".5");
+  }
+  os << "]";
+  string json = os.str();
+
+  istringstream ss(json + " " + json);
+  vector<double> d;
+  vector<float> f;
+  json_in(ss) >> d >> f;
+  BOOST_REQUIRE_EQUAL( d.size(), 10000 );
+  BOOST_REQUIRE_EQUAL( f.size(), 10000 );
+  for (int i = 0; i < 10000; ++i) {
+    double expect = (i % 2 ? -i : i) + (i % 3 ? 0.0 : (i % 2 ? -0.5 : 0.5));
+    if (d[i] != expect || f[i] != float(expect)) {
+      BOOST_ERROR( "wrong number at " << i );
+      break;
+    }
+  }
+
+  istringstream ss2(R"({"a":[1, -2, 3000000000], "b":[1, 2.5]} [7, "8"])");
+  ijstream jin = json_in(ss2);
+  ijobject ijo = jin.get().object();
+  vector<int64_t> i64;
+  vector<int32_t> i32;
+  string key;
+  ijo >> tie(key, i64);
+  BOOST_CHECK( (i64 == vector<int64_t>{1, -2, 3000000000}) );
+  BOOST_CHECK( !ijo.get().read(i32) );
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( read_numbers_bad_test )
+{
+  istringstream ss(R"([1, 2, "three"])");
+  vector<int64_t> v;
+  BOOST_CHECK( !json_in(ss).get().read(v) );
+  istringstream ss2(R"([1, 2, 3000000000])");
+  vector<int32_t> v32;
+  BOOST_CHECK( !json_in(ss2).get().read(v32) );
+  // bulk reads accept exactly what element reads accept
+  for (char const* text : {"[1.]", "[-.5]", "[00.5]", "[1e+]", "[+1]"}) {
+    istringstream ss3(text);
+    vector<double> bulk;
+    bool bulk_ok = json_in(ss3).get().read(bulk);
+    istringstream ss4(text);
+    double x = 0;
+    bool ok = json_in(ss4).get().array().get().read(x);
+    BOOST_CHECK_MESSAGE( bulk_ok == ok, text );
+    BOOST_CHECK_MESSAGE( !ok || (bulk == vector<double>{x}), text );
+  }
+  istringstream ss5("[-0.5e+2, 0, 1E3]");
+  vector<double> d;
+  BOOST_CHECK( json_in(ss5).get().read(d) );
+  BOOST_CHECK( (d == vector<double>{-50, 0, 1000}) );
+}
+
+BOOST_AUTO_TEST_CASE( row_major_test )
+{
+  istringstream ss("[[1, 2, 3], [4, 5, 6]] [[1, 2], [3]]");
+  ijstream jin = json_in(ss);
+  row_major<double> m;
+  jin >> m;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( m.rows, 2 );
+  BOOST_CHECK_EQUAL( m.cols, 3 );
+  BOOST_CHECK_EQUAL( m(1, 0), 4 );
+  BOOST_CHECK( !jin.get().read(m) );
+}
+
+BOOST_AUTO_TEST_CASE( raw_json_copy_test )
+{
+  string text = R"({"a":2.50,"b":[1.0e1,"x/y",{}]})";
+  istringstream ss(text + " " + text);
+  ijstream jin = json_in(ss);
+  ostringstream os;
+  jios_read(jin.get(), lined_json_out(os).put());
+  BOOST_CHECK_EQUAL( os.str(), text + "\n" );
+  ostringstream pretty;
+  jios_read(jin.get(), json_out(pretty).put());
+  BOOST_CHECK_EQUAL( pretty.str(),
+                     "{\n\t\"a\":2.50,\n\t\"b\":[\n\t\t1.0e1,\n"
+                     "\t\t\"x/y\",\n\t\t{}\n\t]\n}" );
+  BOOST_CHECK( !jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( null_values_test )
+{
+  istringstream ss(R"(null {"a": null, "b": 1} [null, 2] null)");
+  ijstream jin = json_in(ss);
+  BOOST_CHECK( jin.get().type() == json_type::jnull );
+  ijobject ijo = jin.get().object();
+  BOOST_CHECK( ijo.get().type() == json_type::jnull );
+  string key;
+  int b = 0;
+  ijo >> tie(key, b);
+  BOOST_CHECK_EQUAL( b, 1 );
+  BOOST_CHECK( ijo.at_end() );
+  ijarray ija = jin.get().array();
+  BOOST_CHECK( ija.get().type() == json_type::jnull );
+  int two = 0;
+  ija >> two;
+  BOOST_CHECK_EQUAL( two, 2 );
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( jin.get().type() == json_type::jnull );
+  BOOST_CHECK( jin.at_end() );
+  BOOST_CHECK( !jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( raw_number_test )
+{
+  istringstream ss(R"([1.50, -7, 2e3, 123456789012345678901234567890.5, "x"])");
+  ijarray ija = json_in(ss).get().array();
+  BOOST_CHECK_EQUAL( ija.get().raw_number(), "1.50" );
+  BOOST_CHECK_EQUAL( ija.get().raw_number(), "-7" );
+  number_text n;
+  ija >> n;
+  BOOST_CHECK_EQUAL( n.text, "2e3" );
+  ija >> n;
+  BOOST_CHECK_EQUAL( n.text, "123456789012345678901234567890.5" );
+  ostringstream os;
+  lined_json_out(os) << n;
+  BOOST_CHECK_EQUAL( os.str(), "123456789012345678901234567890.5\n" );
+  BOOST_CHECK( !ija.fail() );
+  BOOST_CHECK( ija.get().raw_number().empty() );
+  BOOST_CHECK( ija.fail() );
+
+  for (char const* bad : {"", "abc", "12x", "1.", "+1", "01", "1 2"}) {
+    ostringstream bad_os;
+    ojstream jout = lined_json_out(bad_os);
+    jout << number_text{bad};
+    BOOST_CHECK_MESSAGE( jout.fail(), bad );
+    BOOST_CHECK_MESSAGE( bad_os.str().empty(), bad );
+  }
+  ostringstream good_os;
+  lined_json_out(good_os) << number_text{"-0.5E+3"};
+  BOOST_CHECK_EQUAL( good_os.str(), "-0.5E+3\n" );
+}
+
+BOOST_AUTO_TEST_CASE( parse_tuple_test )
+{
+  istringstream ss(R"([1, "two", 3.5] ["a", 2] [1.5, 2.5] [1, 2] [1])");
+  ijstream jin = json_in(ss);
+  tuple<int, string, double> t;
+  pair<string, int64_t> p;
+  array<double, 2> a;
+  jin >> t >> p >> a;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK( (t == make_tuple(1, string("two"), 3.5)) );
+  BOOST_CHECK( (p == make_pair(string("a"), int64_t(2))) );
+  BOOST_CHECK( (a == array<double, 2>{{1.5, 2.5}}) );
+
+  tuple<int> one;
+  BOOST_CHECK( jin.get().read(one) == false );
+  istringstream ss2("[1]");
+  BOOST_CHECK( json_in(ss2).get().read(p) == false );
+}
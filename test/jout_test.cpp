@@ -108,6 +108,17 @@ BOOST_AUTO_TEST_CASE( lined_json_test )
   BOOST_CHECK_EQUAL( ss.str(), "{\"A\":[\"B\",\"C\"]}\n" );
 }
 
+BOOST_AUTO_TEST_CASE( indented_json_test )
+{
+  ostringstream ss;
+  ojobject ojo = json_out(ss, "  ").put().object(true);
+  ojarray oja = ojo.put("A").array(true);
+  oja << 1 << 2;
+  oja.terminate();
+  ojo.terminate();
+  BOOST_CHECK_EQUAL( ss.str(), "{\n  \"A\":[\n    1,\n    2\n  ]\n}" );
+}
+
 struct some_base { int foo; };
 
 struct some_derived : some_base { int bar; };
@@ -126,3 +137,68 @@ BOOST_AUTO_TEST_CASE( custom_base_jios_write )
   BOOST_CHECK_EQUAL( ss.str(), "1015" );
 }
 
+
+template<class Container>
+void check_same_as_elementwise(Container const& c, int precision = 6)
+{
+  ostringstream bulk, each, lined_bulk, lined_each;
+  bulk.precision(precision);
+  each.precision(precision);
+  json_out(bulk) << c;
+  json_out(each) << boost::make_iterator_range(c);
+  BOOST_CHECK_EQUAL( bulk.str(), each.str() );
+  lined_json_out(lined_bulk) << c << c;
+  lined_json_out(lined_each) << boost::make_iterator_range(c)
+                             << boost::make_iterator_range(c);
+  BOOST_CHECK_EQUAL( lined_bulk.str(), lined_each.str() );
+}
+
+BOOST_AUTO_TEST_CASE( write_numbers_test )
+{
+  vector<double> d;
+  vector<float> f;
+  vector<int64_t> i64;
+  vector<int32_t> i32;
+  for (int i = 0; i < 2000; ++i) {
+    d.push_back(i * 1.0000001 - 1e3 + (i % 7 ? 0 : 1e300));
+    f.push_back(i * 0.25f);
+    i64.push_back((i % 2 ? -1 : 1) * (int64_t(1) << (i % 64)));
+    i32.push_back(i * 1000 - 1000000);
+  }
+  i64.push_back(numeric_limits<int64_t>::min());
+  d.push_back(numeric_limits<double>::infinity());
+  check_same_as_elementwise(d);
+  check_same_as_elementwise(d, 17);
+  check_same_as_elementwise(f);
+  check_same_as_elementwise(i64);
+  check_same_as_elementwise(i32);
+  check_same_as_elementwise(vector<double>());
+  check_same_as_elementwise(array<int64_t, 3>{{1, 2, 3}});
+
+  ostringstream ss;
+  ojarray oja = json_out(ss).put().array();
+  oja << "a";
+  oja.write_numbers(i32.data(), 2);
+  oja << "b";
+  oja.terminate();
+  BOOST_CHECK_EQUAL( ss.str(), R"(["a", -1000000, -999000, "b"])" );
+}
+
+BOOST_AUTO_TEST_CASE( ostream_fail_test )
+{
+  ostringstream ss;
+  ojstream jout = lined_json_out(ss);
+  jout << 1;
+  BOOST_CHECK( !jout.fail() );
+  ss.setstate(ios_base::badbit);
+  jout << 2;
+  BOOST_CHECK( jout.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( tuple_write_test )
+{
+  ostringstream ss;
+  lined_json_out(ss) << make_tuple(1, "two", 3.5) << make_pair("a", true)
+                     << tuple<>();
+  BOOST_CHECK_EQUAL( ss.str(), "[1,\"two\",3.5]\n[\"a\",true]\n[]\n" );
+}
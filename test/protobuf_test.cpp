@@ -0,0 +1,596 @@
+#include <boost/test/unit_test.hpp>
+
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/util/delimited_message_util.h>
+#include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
+#include <jios/protobuf_binary.hpp>
+#include <jios/protobuf_projection.hpp>
+#include <jios/tape.hpp>
+#include "jios_test.jios.hpp"
+
+using namespace std;
+using namespace jios;
+using google::protobuf::Message;
+
+namespace {
+
+jios::test::Shape sample_shape()
+{
+  jios::test::Shape ret;
+  ret.set_name("triangle");
+  ret.set_sides(3);
+  ret.set_closed(false);
+  for (int i = 0; i < 3; ++i) {
+    jios::test::Point * p = ret.add_points();
+    p->set_x(i * 0.5);
+    if (i > 0) { p->set_y(-i); }
+  }
+  ret.add_ids(7);
+  ret.add_tags("a");
+  ret.add_tags("b");
+  ret.mutable_style()->set_width(1.5);
+  ret.set_default_(9);
+  return ret;
+}
+
+template<typename T>
+string json_text(T const& src)
+{
+  ostringstream ss;
+  json_out(ss) << src;
+  return ss.str();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE( protobuf_generated_write_test )
+{
+  jios::test::Shape shape = sample_shape();
+  string text = json_text(shape);
+  BOOST_CHECK_EQUAL( text, json_text(static_cast<Message const&>(shape)) );
+  BOOST_CHECK( text.find("\"default\"") != string::npos );
+
+  // generated code writes uint64 where reflection does not
+  jios::test::Shape big;
+  big.set_area_bits(uint64_t(1) << 40);
+  BOOST_CHECK_EQUAL( json_text(big), "{\"area_bits\":1099511627776}" );
+
+  BOOST_CHECK_EQUAL( json_text(jios::test::Shape()), "{}" );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_generated_read_test )
+{
+  string text = json_text(sample_shape());
+  jios::test::Shape generated, reflected;
+  istringstream ss(text);
+  json_in(ss) >> generated;
+  BOOST_CHECK( generated.SerializeAsString()
+               == sample_shape().SerializeAsString() );
+
+  istringstream ss2(text);
+  json_in(ss2).get().read(static_cast<Message &>(reflected));
+  BOOST_CHECK( generated.SerializeAsString()
+               == reflected.SerializeAsString() );
+
+  istringstream big(R"({"area_bits": 1099511627776, "ids": [1, 2]})");
+  json_in(big) >> generated;
+  BOOST_CHECK_EQUAL( generated.area_bits(), uint64_t(1) << 40 );
+  BOOST_CHECK_EQUAL( generated.ids_size(), 2 );
+  BOOST_CHECK( !generated.has_name() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_generated_fail_test )
+{
+  jios::test::Shape shape;
+  istringstream unknown(R"({"sides": 4, "corners": 4})");
+  ijstream jin = json_in(unknown);
+  jin >> shape;
+  BOOST_CHECK( jin.fail() );
+
+  jios::test::Point point;
+  istringstream missing(R"({"y": 1})");
+  ijstream jin2 = json_in(missing);
+  jin2 >> point;
+  BOOST_CHECK( jin2.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_reflection_fallback_test )
+{
+  // messages with enum fields are left to reflection
+  jios::test::Plain plain;
+  plain.set_label("x");
+  BOOST_CHECK_EQUAL( json_text(plain), "{\"label\":\"x\"}" );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_arena_batch_test )
+{
+  ostringstream os;
+  {
+    ojstream out = lined_json_out(os);
+    for (int i = 0; i < 5; ++i) { out << sample_shape(); }
+    out.put().flush();
+  }
+  istringstream ss(os.str());
+  ijstream jin = json_in(ss);
+  proto_arena arena(256);
+  vector<jios::test::Shape *> shapes;
+  BOOST_CHECK_EQUAL( read_batch(jin, arena, shapes, 3), 3 );
+  BOOST_CHECK( shapes[2]->GetArena() == arena.get() );
+  BOOST_CHECK_EQUAL( shapes[2]->points_size(), 3 );
+  BOOST_CHECK_EQUAL( read_batch(jin, arena, shapes, 3), 2 );
+  BOOST_CHECK( shapes[1]->SerializeAsString()
+               == sample_shape().SerializeAsString() );
+  BOOST_CHECK_EQUAL( read_batch(jin, arena, shapes), 0 );
+  BOOST_CHECK( !jin.fail() );
+  // first block grew to the space taken by a batch
+  BOOST_CHECK_GT( arena.block_size(), 256 );
+
+  istringstream points(R"({"x": 1} {"x": 2, "y": 3} {"y": 4})");
+  ijstream pjin = json_in(points);
+  vector<Message *> messages;
+  BOOST_CHECK_EQUAL( read_batch(pjin, arena, jios::test::Point(), messages),
+                     2 );
+  BOOST_CHECK( pjin.fail() );
+  BOOST_CHECK_EQUAL( messages[1]->ShortDebugString(), "x: 2 y: 3" );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_write_delimited_test )
+{
+  ostringstream os;
+  {
+    ojstream out = lined_json_out(os);
+    for (int i = 0; i < 3; ++i) { out << sample_shape(); }
+    out.put().flush();
+  }
+  istringstream ss(os.str());
+  ijstream jin = json_in(ss);
+  string bytes;
+  {
+    google::protobuf::io::StringOutputStream raw(&bytes);
+    google::protobuf::io::CodedOutputStream out(&raw);
+    BOOST_CHECK_EQUAL( write_delimited(jin, jios::test::Shape::descriptor(),
+                                       out),
+                       3 );
+  }
+  BOOST_CHECK( !jin.fail() );
+
+  google::protobuf::io::ArrayInputStream raw(bytes.data(), bytes.size());
+  for (int i = 0; i < 3; ++i) {
+    jios::test::Shape shape;
+    BOOST_REQUIRE( google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+                       &shape, &raw, nullptr) );
+    BOOST_CHECK( shape.SerializeAsString()
+                 == sample_shape().SerializeAsString() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_encoder_test )
+{
+  proto_encoder encoder(jios::test::Sample::descriptor());
+  istringstream ss(R"(
+    {"delta": -3, "values": [1, -2, 300], "stamp": 12, "kind": "LARGE",
+     "shapes": [{"name": "a", "points": [{"x": 1}]}, {"sides": 4}],
+     "blob": "xyz", "offset": -7, "kinds": ["LARGE", 0]}
+    {"nothing": 1}
+    {"shapes": [{"points": [{"y": 2}]}]}
+  )");
+  ijstream jin = json_in(ss);
+  jios::test::Sample sample;
+  BOOST_REQUIRE( sample.ParseFromString(encoder.encode(jin.get())) );
+  BOOST_CHECK_EQUAL( sample.delta(), -3 );
+  BOOST_CHECK_EQUAL( sample.values_size(), 3 );
+  BOOST_CHECK_EQUAL( sample.values(1), -2 );
+  BOOST_CHECK_EQUAL( sample.stamp(), 12 );
+  BOOST_CHECK( sample.kind() == jios::test::Plain::LARGE );
+  BOOST_CHECK_EQUAL( sample.shapes(0).points(0).x(), 1 );
+  BOOST_CHECK_EQUAL( sample.shapes(1).sides(), 4 );
+  BOOST_CHECK_EQUAL( sample.blob(), "xyz" );
+  BOOST_CHECK_EQUAL( sample.offset(), -7 );
+  BOOST_CHECK( sample.kinds(1) == jios::test::Plain::SMALL );
+  BOOST_CHECK( !jin.fail() );
+
+  // unknown key
+  encoder.encode(jin.get());
+  BOOST_CHECK( jin.fail() );
+
+  // missing required field of a nested message
+  istringstream missing(R"({"shapes": [{"points": [{"y": 2}]}]})");
+  ijstream jin2 = json_in(missing);
+  encoder.encode(jin2.get());
+  BOOST_CHECK( jin2.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_encoder_required_test )
+{
+  proto_encoder encoder(google::protobuf::UninterpretedOption::
+                            NamePart::descriptor());
+  // a tape keeps duplicate keys, which json-c would merge
+  tape t;
+  ojstream out = tape_out(t);
+  ojobject complete = out.put().object();
+  complete << make_pair("name_part", "a")
+           << make_pair("is_extension", false);
+  complete.terminate();
+  ojobject repeated = out.put().object();
+  repeated << make_pair("name_part", "a")
+           << make_pair("name_part", "b");
+  repeated.terminate();
+  ijstream jin = tape_in(t);
+  encoder.encode(jin.get());
+  BOOST_CHECK( !jin.fail() );
+  encoder.encode(jin.get());
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_delimited_in_test )
+{
+  jios::test::Sample sample;
+  sample.set_delta(-3);
+  sample.add_values(1);
+  sample.add_values(300);
+  sample.set_kind(jios::test::Plain::LARGE);
+  *sample.add_shapes() = sample_shape();
+  sample.add_shapes()->set_sides(4);
+  sample.set_offset(-7);
+  sample.add_kinds(jios::test::Plain::SMALL);
+
+  ostringstream os;
+  for (int i = 0; i < 2; ++i) {
+    google::protobuf::util::SerializeDelimitedToOstream(sample, &os);
+  }
+  google::protobuf::util::SerializeDelimitedToOstream(sample_shape(), &os);
+
+  istringstream ss(os.str());
+  ijstream jin = protobuf_delimited_in(ss, jios::test::Sample::descriptor());
+  ostringstream text;
+  ojstream out = lined_json_out(text);
+  jios_read(jin.get(), out.put());
+  out.put().flush();
+  string const prefix
+      = R"({"delta":-3,"values":[1,300],"kind":"LARGE","shapes":[{"name")";
+  BOOST_CHECK_EQUAL( text.str().substr(0, prefix.size()), prefix );
+
+  // a Shape in the JSON read back through reflection
+  ijobject ijo = jin.get().object();
+  BOOST_CHECK_EQUAL( ijo.key(), "delta" );
+  int delta = 0;
+  ijo.get().read(delta);
+  BOOST_CHECK_EQUAL( delta, -3 );
+  while (ijo.key() != "shapes") { ijo.get().skip(); }
+  ijarray shapes = ijo.get().array();
+  jios::test::Shape shape;
+  shapes.get().read(static_cast<Message &>(shape));
+  BOOST_CHECK( shape.SerializeAsString()
+               == sample_shape().SerializeAsString() );
+  shapes >> shape;
+  BOOST_CHECK_EQUAL( shape.sides(), 4 );
+  BOOST_CHECK( shapes.at_end() );
+  while (!ijo.at_end()) { ijo.get().skip(); }
+  BOOST_CHECK( !jin.fail() );
+
+  // a Shape read as a Sample fails on mismatched wire types
+  jios_read(jin.get(), out.put());
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_uint64_range_test )
+{
+  proto_encoder encoder(jios::test::Shape::descriptor());
+  istringstream ss(R"(
+    {"area_bits": 9223372036854775808}
+    {"area_bits": 18446744073709551615}
+    {"area_bits": -1}
+  )");
+  ijstream jin = json_in(ss);
+  string bytes;
+  for (int i = 0; i < 2; ++i) {
+    string const& message = encoder.encode(jin.get());
+    BOOST_REQUIRE( !jin.fail() );
+    bytes += char(message.size());
+    bytes += message;
+  }
+  jios::test::Shape shape;
+  BOOST_REQUIRE( shape.ParseFromString(bytes.substr(1, bytes[0])) );
+  BOOST_CHECK_EQUAL( shape.area_bits(), uint64_t(1) << 63 );
+  encoder.encode(jin.get());
+  BOOST_CHECK( jin.fail() );
+
+  istringstream in(bytes);
+  ijstream pin = protobuf_delimited_in(in, jios::test::Shape::descriptor());
+  ostringstream text;
+  jios_read(pin.get(), lined_json_out(text).put());
+  jios_read(pin.get(), lined_json_out(text).put());
+  BOOST_CHECK_EQUAL( text.str(), "{\"area_bits\":9223372036854775808}\n"
+                                 "{\"area_bits\":18446744073709551615}\n" );
+
+  istringstream again(bytes);
+  pin = protobuf_delimited_in(again, jios::test::Shape::descriptor());
+  ijobject ijo = pin.get().object();
+  BOOST_CHECK_EQUAL( ijo.get().raw_number(), "9223372036854775808" );
+  ijo = pin.get().object();
+  double d = 0;
+  ijo.get().read(d);
+  BOOST_CHECK_EQUAL( d, 18446744073709551615.0 );
+  BOOST_CHECK( !pin.fail() );
+
+  istringstream signed_read(bytes);
+  pin = protobuf_delimited_in(signed_read, jios::test::Shape::descriptor());
+  int64_t i = 0;
+  pin.get().object().get().read(i);
+  BOOST_CHECK( pin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_delimited_in_scattered_test )
+{
+  jios::test::Shape first;
+  first.set_name("a");
+  first.add_ids(7);
+  first.set_sides(3);
+  jios::test::Shape second;
+  second.set_name("b");
+  second.add_ids(8);
+  second.add_points()->set_x(1);
+  string body = first.SerializeAsString() + second.SerializeAsString();
+  jios::test::Shape merged = first;
+  merged.MergeFrom(second);
+
+  istringstream ss(char(body.size()) + body);
+  ijstream jin = protobuf_delimited_in(ss, jios::test::Shape::descriptor());
+  ijobject ijo = jin.get().object();
+  vector<string> keys;
+  string name;
+  vector<int64_t> ids;
+  while (!ijo.at_end()) {
+    keys.push_back(ijo.key());
+    if (keys.back() == "ids") {
+      ijo.get().read(ids);
+    } else if (keys.back() == "name") {
+      ijo.get().read(name);
+    } else {
+      ijo.get().skip();
+    }
+  }
+  BOOST_CHECK( (keys == vector<string>{"name", "sides", "ids", "points"}) );
+  BOOST_CHECK_EQUAL( name, merged.name() );
+  BOOST_CHECK( (ids == vector<int64_t>(merged.ids().begin(),
+                                       merged.ids().end())) );
+  BOOST_CHECK( !jin.fail() );
+
+  // entries of a singular message field would merge
+  first.mutable_style()->set_color("red");
+  second.mutable_style()->set_width(2);
+  body = first.SerializeAsString() + second.SerializeAsString();
+  istringstream styles(char(body.size()) + body);
+  jin = protobuf_delimited_in(styles, jios::test::Shape::descriptor());
+  ostringstream text;
+  jios_read(jin.get(), lined_json_out(text).put());
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_delimited_in_max_size_test )
+{
+  ostringstream os;
+  google::protobuf::util::SerializeDelimitedToOstream(sample_shape(), &os);
+  string const bytes = os.str();
+
+  istringstream ss(bytes);
+  ijstream jin = protobuf_delimited_in(ss, jios::test::Shape::descriptor(),
+                                       bytes.size() - 2);
+  BOOST_CHECK( jin.at_end() );
+  BOOST_CHECK( jin.fail() );
+
+  istringstream fits(bytes);
+  jin = protobuf_delimited_in(fits, jios::test::Shape::descriptor(),
+                              bytes.size() - 1);
+  jios::test::Shape shape;
+  jin >> shape;
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( shape.name(), "triangle" );
+
+  // a length prefix beyond the default limit is not allocated
+  istringstream huge("\xff\xff\xff\xff\x0f");
+  jin = protobuf_delimited_in(huge, jios::test::Shape::descriptor());
+  BOOST_CHECK( jin.at_end() );
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_out_test )
+{
+  jios::test::Shape shape;
+  ojstream out = protobuf_out(shape);
+  out << sample_shape();
+  BOOST_CHECK( !out.fail() );
+  BOOST_CHECK( shape.SerializeAsString()
+               == sample_shape().SerializeAsString() );
+
+  // each top-level object replaces the message
+  jios::test::Shape small;
+  small.set_sides(4);
+  out << small;
+  BOOST_CHECK_EQUAL( shape.ShortDebugString(), "sides: 4" );
+
+  jios::test::Sample sample;
+  ojstream sample_out = protobuf_out(sample);
+  ojobject ojo = sample_out.put().object();
+  ojo << make_pair("delta", -3)
+      << make_pair("values", vector<int64_t>{1, 2})
+      << make_pair("kind", "LARGE")
+      << make_pair("stamp", 12.0)
+      << make_pair("kinds", vector<int>{1, 0});
+  ojarray shapes = ojo["shapes"].array();
+  ojobject first = shapes->object();
+  first << make_pair("name", "a");
+  ojarray points = first["points"].array();
+  points->object() << make_pair("x", 1.5);
+  points.terminate();
+  first.terminate();
+  shapes.terminate();
+  ojo.terminate();
+  BOOST_CHECK( !sample_out.fail() );
+  BOOST_CHECK_EQUAL( sample.delta(), -3 );
+  BOOST_CHECK_EQUAL( sample.values_size(), 2 );
+  BOOST_CHECK( sample.kind() == jios::test::Plain::LARGE );
+  BOOST_CHECK_EQUAL( sample.stamp(), 12 );
+  BOOST_CHECK( sample.kinds(0) == jios::test::Plain::LARGE );
+  BOOST_CHECK_EQUAL( sample.shapes(0).name(), "a" );
+  BOOST_CHECK_EQUAL( sample.shapes(0).points(0).x(), 1.5 );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_out_uint64_test )
+{
+  jios::test::Shape shape;
+  ojstream out = protobuf_out(shape);
+  istringstream ss(R"(
+    {"area_bits": 18446744073709551615}
+    {"area_bits": 2.0}
+    {"area_bits": -1}
+  )");
+  ijstream jin = json_in(ss);
+  jios_read(jin.get(), out.put());
+  BOOST_CHECK( !out.fail() );
+  BOOST_CHECK_EQUAL( shape.area_bits(), numeric_limits<uint64_t>::max() );
+  jios_read(jin.get(), out.put());
+  BOOST_CHECK_EQUAL( shape.area_bits(), 2 );
+  BOOST_CHECK( !out.fail() );
+
+  ojobject ojo = out.put().object();
+  ojo << make_pair("area_bits", number_text{"9223372036854775808"});
+  ojo.terminate();
+  BOOST_CHECK( !out.fail() );
+  BOOST_CHECK_EQUAL( shape.area_bits(), uint64_t(1) << 63 );
+
+  // binary input keeps the full range through the transcoder
+  jios::test::Shape big;
+  big.set_area_bits(numeric_limits<uint64_t>::max());
+  ostringstream os;
+  google::protobuf::util::SerializeDelimitedToOstream(big, &os);
+  istringstream bin(os.str());
+  ijstream pin = protobuf_delimited_in(bin, jios::test::Shape::descriptor());
+  jios_read(pin.get(), out.put());
+  BOOST_CHECK( !out.fail() );
+  BOOST_CHECK_EQUAL( shape.area_bits(), numeric_limits<uint64_t>::max() );
+
+  jios_read(jin.get(), out.put());
+  BOOST_CHECK( out.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_out_fail_test )
+{
+  jios::test::Shape shape;
+  {
+    ojstream out = protobuf_out(shape);
+    out.put().object() << make_pair("sides", "four");
+    BOOST_CHECK( out.fail() );
+  }
+  {
+    ojstream out = protobuf_out(shape);
+    out.put().object() << make_pair("corners", 4) << make_pair("sides", 3);
+    BOOST_CHECK( out.fail() );
+    BOOST_CHECK( !shape.has_sides() );
+  }
+  {
+    ojstream out = protobuf_out(shape);
+    out.put().object() << make_pair("sides", int64_t(1) << 40);
+    BOOST_CHECK( out.fail() );
+  }
+  {
+    jios::test::Point point;
+    ojstream out = protobuf_out(point);
+    ojobject ojo = out.put().object();
+    ojo << make_pair("y", 1);
+    BOOST_CHECK( !out.fail() );
+    ojo.terminate();
+    BOOST_CHECK( out.fail() );
+  }
+  {
+    ojstream out = protobuf_out(shape);
+    out << 1;
+    BOOST_CHECK( out.fail() );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_projection_write_test )
+{
+  google::protobuf::FieldMask mask;
+  mask.add_paths("name");
+  mask.add_paths("points.y");
+  mask.add_paths("style");
+  proto_projection proj(jios::test::Shape::descriptor(), mask);
+  jios::test::Shape const shape = sample_shape();
+  ostringstream os;
+  ojstream out = lined_json_out(os);
+  out << projected(shape, proj);
+  out.put().flush();
+  BOOST_CHECK_EQUAL( os.str(), R"({"name":"triangle","points":[{},{"y":-1},)"
+                               R"({"y":-2}],"style":{"width":1.5}})" "\n" );
+
+  // a field is selected whole once any path ends at it
+  proto_projection whole(jios::test::Shape::descriptor(),
+                         {"points.x", "points", "points.y"});
+  jios::test::Shape points_only;
+  *points_only.mutable_points() = shape.points();
+  BOOST_CHECK_EQUAL( json_text(projected(shape, whole)),
+                     json_text(static_cast<Message const&>(points_only)) );
+
+  BOOST_CHECK_THROW( proto_projection(jios::test::Shape::descriptor(),
+                                      {"points.z"}),
+                     invalid_argument );
+  BOOST_CHECK_THROW( proto_projection(jios::test::Shape::descriptor(),
+                                      {"name.x"}),
+                     invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_projection_path_test )
+{
+  google::protobuf::Descriptor const* desc = jios::test::Shape::descriptor();
+  BOOST_CHECK_THROW( proto_projection(desc, {"style", "style.bogus"}),
+                     invalid_argument );
+  BOOST_CHECK_THROW( proto_projection(desc, {"style.bogus", "style"}),
+                     invalid_argument );
+  BOOST_CHECK_THROW( proto_projection(desc, {"points", "points.x.y"}),
+                     invalid_argument );
+  BOOST_CHECK_THROW( proto_projection(desc, {"points.x.y", "points"}),
+                     invalid_argument );
+  BOOST_CHECK_NO_THROW( proto_projection(desc, {"points", "points.x"}) );
+}
+
+BOOST_AUTO_TEST_CASE( protobuf_projection_read_test )
+{
+  proto_projection proj(jios::test::Shape::descriptor(),
+                        {"sides", "points.y", "style.color"});
+  istringstream ss(json_text(sample_shape()));
+  ijstream jin = json_in(ss);
+  jios::test::Shape shape;
+  shape.set_name("replaced");
+  jios_read(jin.get(), projected(shape, proj));
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( shape.ShortDebugString(),
+                     "sides: 3 points { } points { y: -1 } points { y: -2 } "
+                     "style { }" );
+
+  istringstream unknown(R"({"sides": 3, "corners": 3})");
+  ijstream jin2 = json_in(unknown);
+  jios_read(jin2.get(), projected(shape, proj));
+  BOOST_CHECK( jin2.fail() );
+
+  // required fields count only where selected
+  proto_projection xs(jios::test::Shape::descriptor(), {"points.x"});
+  string const points = R"({"points": [{"x": 1}, {"y": 2}]})";
+  istringstream unselected(points);
+  ijstream jin3 = json_in(unselected);
+  jios_read(jin3.get(), projected(shape, proj));
+  BOOST_CHECK( !jin3.fail() );
+  BOOST_CHECK_EQUAL( shape.points_size(), 2 );
+  istringstream missing(points);
+  jin3 = json_in(missing);
+  jios_read(jin3.get(), projected(shape, xs));
+  BOOST_CHECK( jin3.fail() );
+
+  proto_projection whole(jios::test::Shape::descriptor(), {"points"});
+  istringstream partial(R"({"points": [{"y": 2}]})");
+  ijstream jin4 = json_in(partial);
+  jios_read(jin4.get(), projected(shape, whole));
+  BOOST_CHECK( jin4.fail() );
+}
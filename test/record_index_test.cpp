@@ -0,0 +1,111 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/record_index.hpp>
+#include <jios/json_in.hpp>
+
+using namespace std;
+using namespace jios;
+
+string numbered_records(int count, bool array)
+{
+  string ret = (array ? "[\n" : "");
+  for (int i = 0; i < count; ++i) {
+    if (array && i > 0) ret += ",\n";
+    ret += "{\"id\": " + to_string(i) + ", \"tags\": [\"a,]\", \"}\"]}";
+    if (!array) ret += "\n";
+  }
+  if (array) ret += "\n]";
+  return ret;
+}
+
+void check_ids(ijstream & jin, int first, int last)
+{
+  int i = first;
+  while (!jin.at_end()) {
+    ijobject ijo = jin.get().object();
+    int id = -1;
+    string key;
+    ijo >> tie(key, id);
+    ijo.skip();
+    BOOST_CHECK( ijo.at_end() );
+    if (id != i) break;
+    ++i;
+  }
+  BOOST_CHECK( !jin.fail() );
+  BOOST_CHECK_EQUAL( i, last );
+}
+
+BOOST_AUTO_TEST_CASE( record_index_seek_test )
+{
+  for (bool array : {false, true}) {
+    for (size_t stride : {1, 7}) {
+      istringstream ss(numbered_records(100, array));
+      record_index idx = build_record_index(ss, stride);
+      BOOST_CHECK_EQUAL( idx.array(), array );
+      BOOST_CHECK_EQUAL( idx.size(), 100 );
+      BOOST_CHECK_EQUAL( idx.offsets().size(), (100 + stride - 1) / stride );
+      ijstream tail = indexed_json_in(ss, idx, 45);
+      check_ids(tail, 45, 100);
+      ijstream page = indexed_json_in(ss, idx, 10, 20);
+      check_ids(page, 10, 30);
+      ijstream none = indexed_json_in(ss, idx, 100);
+      check_ids(none, 100, 100);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( record_index_skip_unparsed_test )
+{
+  // records before the seek target within a stride are scanned, not
+  // parsed, so a malformed one in between is not noticed
+  istringstream ss("{\"id\": 0, \"x\": 0}\n{\"id\": 1, oops}\n"
+                   "{\"id\": 2, \"x\": 0}\n{\"id\": 3, \"x\": 0}\n");
+  record_index idx = build_record_index(ss, 4);
+  BOOST_CHECK_EQUAL( idx.size(), 4 );
+  BOOST_CHECK_EQUAL( idx.offsets().size(), 1 );
+  ijstream jin = indexed_json_in(ss, idx, 2);
+  check_ids(jin, 2, 4);
+}
+
+BOOST_AUTO_TEST_CASE( record_index_partition_test )
+{
+  string data = numbered_records(50, false);
+  istringstream ss(data);
+  record_index idx = build_record_index(ss, 3);
+  uint64_t const parts = 4;
+  size_t next = 0;
+  for (uint64_t p = 0; p < parts; ++p) {
+    pair<size_t, size_t> range = idx.records_in(data.size() * p / parts,
+                                                data.size() * (p + 1) / parts);
+    BOOST_CHECK_EQUAL( range.first, next );
+    next = range.second;
+    ijstream jin = indexed_json_in(ss, idx, range.first,
+                                   range.second - range.first);
+    check_ids(jin, range.first, range.second);
+  }
+  BOOST_CHECK_EQUAL( next, 50 );
+}
+
+BOOST_AUTO_TEST_CASE( record_index_sidecar_test )
+{
+  istringstream ss("[1, 2, 3] \"four\" 5");
+  record_index idx = build_record_index(ss, 2);
+  BOOST_CHECK( !idx.array() );
+  BOOST_CHECK_EQUAL( idx.size(), 3 );
+  stringstream sidecar;
+  idx.save(sidecar);
+  record_index loaded;
+  loaded.load(sidecar);
+  BOOST_CHECK( !sidecar.fail() );
+  BOOST_CHECK( loaded.offsets() == idx.offsets() );
+  BOOST_CHECK_EQUAL( loaded.size(), 3 );
+  int five = 0;
+  indexed_json_in(ss, loaded, 2) >> five;
+  BOOST_CHECK_EQUAL( five, 5 );
+
+  istringstream bad("JIOSRIDX");
+  loaded.load(bad);
+  BOOST_CHECK( bad.fail() );
+  istringstream invalid("[1, 2 3]");
+  BOOST_CHECK_THROW( build_record_index(invalid), runtime_error );
+}
@@ -0,0 +1,274 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/tape_backend.hpp>
+#include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
+
+using namespace std;
+using namespace jios;
+
+string tape_json = R"([1, 2.5, "three", true, {"a":[], "b":{"c":"d"}}])";
+
+void check_tape_array(ijstream && jin)
+{
+  ijarray ija = jin.get().array();
+  BOOST_CHECK( ija.hint_multiline() );
+  int i;
+  double d;
+  string s;
+  bool b;
+  ija >> i >> d >> s >> b;
+  BOOST_CHECK_EQUAL( i, 1 );
+  BOOST_CHECK_EQUAL( d, 2.5 );
+  BOOST_CHECK_EQUAL( s, "three" );
+  BOOST_CHECK( b );
+  ijobject ijo = ija.get().object();
+  BOOST_CHECK_EQUAL( ijo.key(), "a" );
+  BOOST_CHECK( ijo.get().array().at_end() );
+  BOOST_CHECK_EQUAL( ijo.key(), "b" );
+  map<string, string> m;
+  ijo.get().read(m);
+  BOOST_CHECK_EQUAL( m["c"], "d" );
+  BOOST_CHECK( ijo.at_end() );
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( !ija.fail() );
+  BOOST_CHECK( jin.at_end() );
+}
+
+BOOST_AUTO_TEST_CASE( tape_multipass_test )
+{
+  istringstream ss(tape_json);
+  auto p_tape = make_shared<tape>();
+  json_in(ss) >> *p_tape;
+  BOOST_CHECK( !ss.fail() );
+  BOOST_CHECK( !p_tape->empty() );
+
+  check_tape_array(tape_in(p_tape));
+  check_tape_array(tape_in(p_tape));
+
+  tape copy = *p_tape;
+  check_tape_array(tape_in(copy));
+}
+
+BOOST_AUTO_TEST_CASE( tape_print_test )
+{
+  istringstream ss(tape_json);
+  tape t;
+  json_in(ss) >> t;
+
+  ostringstream os;
+  ijstream jin = tape_in(t);
+  jios_read(jin.get(), json_out(os).put());
+  BOOST_CHECK_EQUAL( os.str(), "[\n\t1,\n\t2.5,\n\t\"three\",\n\ttrue,\n"
+                               "\t{\n\t\t\"a\":[],\n"
+                               "\t\t\"b\":{\"c\":\"d\"}\n\t}\n]" );
+}
+
+BOOST_AUTO_TEST_CASE( tape_stream_test )
+{
+  tape t;
+  tape_out(t) << 1 << "two" << nullptr << 3;
+  int i, j;
+  string s;
+  ijstream jin = tape_in(t);
+  jin >> i >> s;
+  BOOST_CHECK_EQUAL( jin.get().type(), json_type::jnull );
+  jin >> j;
+  BOOST_CHECK_EQUAL( i, 1 );
+  BOOST_CHECK_EQUAL( s, "two" );
+  BOOST_CHECK_EQUAL( j, 3 );
+  BOOST_CHECK( jin.at_end() );
+  BOOST_CHECK( !jin.fail() );
+
+  jin = tape_in(t);
+  jin >> s;
+  BOOST_CHECK_EQUAL( s, "1" );
+  jin >> i;
+  BOOST_CHECK( jin.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( tape_size_hint_test )
+{
+  istringstream ss(R"([[1, 2, 3], {"a":1, "b":2}])");
+  tape t;
+  json_in(ss) >> t;
+  ijstream jin = tape_in(t);
+  ijarray ija = jin.get().array();
+  BOOST_CHECK_EQUAL( ija.size_hint(), 2 );
+  ijarray inner = ija.get().array();
+  BOOST_CHECK_EQUAL( inner.size_hint(), 3 );
+  inner.skip();
+  BOOST_CHECK_EQUAL( inner.size_hint(), 2 );
+  while (!inner.at_end()) { inner.skip(); }
+  BOOST_CHECK_EQUAL( ija.size_hint(), 1 );
+  ijobject ijo = ija.get().object();
+  BOOST_CHECK_EQUAL( ijo.size_hint(), 2 );
+}
+
+BOOST_AUTO_TEST_CASE( tape_read_numbers_test )
+{
+  istringstream ss("[[1, 2.5, -3], [1, 2]]");
+  tape t;
+  json_in(ss) >> t;
+  ijstream jin = tape_in(t);
+  ijarray ija = jin.get().array();
+  vector<double> d;
+  vector<int64_t> i;
+  ija >> d;
+  BOOST_CHECK( (d == vector<double>{1, 2.5, -3}) );
+  ija >> i;
+  BOOST_CHECK( (i == vector<int64_t>{1, 2}) );
+  BOOST_CHECK( ija.at_end() );
+  BOOST_CHECK( !ija.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( static_tape_test )
+{
+  tape t;
+  {
+    static_tape_ojstream out = static_tape_out(t);
+    out << 1 << 2.5 << "three" << true << nullptr << vector<int>{4, 5};
+    static_tape_ojstream obj = out.object();
+    obj.key("n") << 6;
+    obj.key("s") << string("seven");
+    obj.terminate();
+  }
+
+  static_tape_ijstream in = static_tape_in(t);
+  int i;
+  double d;
+  string s;
+  bool b;
+  in >> i >> d >> s >> b;
+  BOOST_CHECK_EQUAL( i, 1 );
+  BOOST_CHECK_EQUAL( d, 2.5 );
+  BOOST_CHECK_EQUAL( s, "three" );
+  BOOST_CHECK( b );
+  BOOST_CHECK_EQUAL( in.get().type(), json_type::jnull );
+  vector<int64_t> v;
+  static_tape_ijstream arr = in.array();
+  while (!arr.at_end()) {
+    v.emplace_back();
+    arr >> v.back();
+  }
+  BOOST_CHECK( (v == vector<int64_t>{4, 5}) );
+  ijstream erased = in.erased();
+  map<string, string> m;
+  erased >> m;
+  BOOST_CHECK_EQUAL( m["n"], "6" );
+  BOOST_CHECK_EQUAL( m["s"], "seven" );
+  BOOST_CHECK( erased.at_end() );
+  BOOST_CHECK( !erased.fail() );
+
+  static_tape_ijstream again = static_tape_in(t);
+  again >> s;
+  BOOST_CHECK_EQUAL( s, "1" );
+  again >> b;
+  BOOST_CHECK( again.fail() );
+  BOOST_CHECK( again.at_end() );
+}
+
+BOOST_AUTO_TEST_CASE( tape_raw_number_test )
+{
+  tape t;
+  tape_out(t) << 42 << 2.0 << 0.1;
+  ijstream jin = tape_in(t);
+  BOOST_CHECK_EQUAL( jin.get().raw_number(), "42" );
+  BOOST_CHECK_EQUAL( jin.get().raw_number(), "2.0" );
+  number_text n;
+  jin >> n;
+  BOOST_CHECK_EQUAL( strtod(n.text.c_str(), nullptr), 0.1 );
+  tape copy;
+  tape_out(copy) << n;
+  double d = 0;
+  tape_in(copy) >> d;
+  BOOST_CHECK_EQUAL( d, 0.1 );
+
+  tape inf;
+  tape_out(inf) << numeric_limits<double>::infinity();
+  ijstream inf_in = tape_in(inf);
+  inf_in.get().raw_number();
+  BOOST_CHECK( inf_in.fail() );
+}
+
+BOOST_AUTO_TEST_CASE( tape_null_test )
+{
+  BOOST_CHECK_THROW( tape_in(shared_ptr<tape const>()), invalid_argument );
+}
+
+BOOST_AUTO_TEST_CASE( tape_real_as_string_test )
+{
+  istringstream ss("[3.14159265358979, 0.1]");
+  tape t;
+  json_in(ss) >> t;
+  vector<string> texts;
+  tape_in(t) >> texts;
+  BOOST_REQUIRE_EQUAL( texts.size(), 2 );
+  BOOST_CHECK_EQUAL( stod(texts[0]), 3.14159265358979 );
+  BOOST_CHECK_EQUAL( stod(texts[1]), 0.1 );
+}
+
+struct static_point
+  : private jobject_expressible<static_point>
+{
+  int64_t x;
+  double y;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("x", &static_point::x)
+       .member("y", &static_point::y);
+  }
+};
+
+struct static_shape
+  : private jobject_compiled_expressible<static_shape>
+{
+  string name;
+  static_point at;
+  vector<int> ids;
+
+  template<class Expression>
+  static
+  void jios_express(Expression & exp)
+  {
+    exp.member("name", &static_shape::name)
+       .member("at", &static_shape::at)
+       .member("ids", &static_shape::ids);
+  }
+};
+
+BOOST_AUTO_TEST_CASE( static_tape_express_test )
+{
+  static_shape src;
+  src.name = "box";
+  src.at.x = 3;
+  src.at.y = 4.5;
+  src.ids = {1, 2};
+  tape t;
+  static_tape_out(t) << src;
+
+  static_shape dest;
+  tape_in(t) >> dest;
+  BOOST_CHECK_EQUAL( dest.name, "box" );
+  BOOST_CHECK_EQUAL( dest.at.y, 4.5 );
+  BOOST_CHECK( (dest.ids == vector<int>{1, 2}) );
+
+  dest = static_shape();
+  static_tape_ijstream in = static_tape_in(t);
+  in >> dest;
+  BOOST_CHECK( !in.fail() );
+  BOOST_CHECK_EQUAL( dest.name, "box" );
+  BOOST_CHECK_EQUAL( dest.at.x, 3 );
+  BOOST_CHECK_EQUAL( dest.at.y, 4.5 );
+  BOOST_CHECK( (dest.ids == vector<int>{1, 2}) );
+  BOOST_CHECK( in.at_end() );
+
+  tape bad;
+  tape_out(bad) << map<string, int>{{"z", 1}};
+  static_tape_ijstream bad_in = static_tape_in(bad);
+  bad_in >> dest;
+  BOOST_CHECK( bad_in.fail() );
+}
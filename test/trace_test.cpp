@@ -0,0 +1,59 @@
+#include <boost/test/unit_test.hpp>
+
+#include <jios/trace.hpp>
+#include <jios/json_in.hpp>
+#include <jios/json_out.hpp>
+
+using namespace std;
+using namespace jios;
+
+BOOST_AUTO_TEST_CASE( latency_histogram_test )
+{
+  latency_histogram h;
+  BOOST_CHECK_EQUAL( h.value_at_percentile(50), 0 );
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    h.record(v);
+  }
+  BOOST_CHECK_EQUAL( h.count(), 1000 );
+  BOOST_CHECK_EQUAL( h.min(), 1 );
+  BOOST_CHECK_EQUAL( h.max(), 1000 );
+  BOOST_CHECK_CLOSE( h.mean(), 500.5, 0.001 );
+  uint64_t p50 = h.value_at_percentile(50);
+  uint64_t p99 = h.value_at_percentile(99);
+  BOOST_CHECK( p50 >= 500 && p50 <= 500 + 500 / 16 );
+  BOOST_CHECK( p99 >= 990 && p99 <= 990 + 990 / 16 );
+  BOOST_CHECK_EQUAL( h.value_at_percentile(100), 1000 );
+
+  latency_histogram big;
+  big.record(numeric_limits<uint64_t>::max());
+  h.merge(big);
+  BOOST_CHECK_EQUAL( h.value_at_percentile(100),
+                     numeric_limits<uint64_t>::max() );
+  h.reset();
+  BOOST_CHECK_EQUAL( h.count(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( trace_hook_test )
+{
+  histogram_trace_hook hook;
+  istringstream is("[1, 2, 3] {\"a\": 4}");
+  ostringstream os;
+  {
+    scoped_trace_hook scope(hook);
+    ijstream jin = json_in(is);
+    ojstream jout = lined_json_out(os);
+    while (!jin.at_end()) {
+      jios_read(jin.get(), jout.put());
+    }
+    jout.put().flush();
+  }
+  BOOST_CHECK_EQUAL( os.str(), "[1,2,3]\n{\"a\":4}\n" );
+  BOOST_CHECK( hook.histogram(trace_event::parse).count() > 0 );
+  BOOST_CHECK( hook.histogram(trace_event::advance).count() > 0 );
+  BOOST_CHECK( hook.histogram(trace_event::write).count() > 0 );
+  BOOST_CHECK( hook.histogram(trace_event::flush).count() > 0 );
+
+  hook.reset();
+  lined_json_out(os) << 5;
+  BOOST_CHECK_EQUAL( hook.histogram(trace_event::write).count(), 0 );
+}
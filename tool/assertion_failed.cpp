@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include <iostream>
+
+// Debug builds define BOOST_ENABLE_ASSERT_HANDLER
+
+namespace boost {
+
+void assertion_failed(char const* expr, char const* func,
+                      char const* file, long line)
+{
+  std::cerr << "Assert failed: (" << expr << ") "
+            << func << ' ' << file << ':' << line << std::endl;
+  std::abort();
+}
+
+void assertion_failed_msg(char const* expr, char const* msg, char const* func,
+                          char const* file, long line)
+{
+  std::cerr << "Assert failed: (" << expr << ") '" << msg << "' "
+            << func << ' ' << file << ':' << line << std::endl;
+  std::abort();
+}
+
+} // namespace boost
@@ -0,0 +1,216 @@
+// jios-fmt: reformat JSON or NDJSON streams in bounded memory
+//
+// Top-level arrays are streamed element by element and other top-level
+// values are parsed one at a time, so memory use is bounded by the
+// largest top-level value or array element rather than the input size.
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <jios/compress.hpp>
+#include <jios/json_out.hpp>
+
+using namespace std;
+using namespace jios;
+
+namespace {
+
+
+//! Buffer writes to a target streambuf ignoring flushes until finish,
+//! since sinks flush after every top-level value.
+class deferred_flush_streambuf : public streambuf
+{
+public:
+  deferred_flush_streambuf(streambuf * p_target)
+    : p_target_(p_target)
+    , buf_(1 << 16)
+    , failed_(false)
+  {
+    setp(buf_.data(), buf_.data() + buf_.size());
+  }
+
+  //! Write all buffered output and flush the target
+  bool finish()
+  {
+    return drain() && p_target_->pubsync() == 0;
+  }
+
+protected:
+  int_type overflow(int_type ch) override
+  {
+    if (!drain()) return traits_type::eof();
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(ch);
+  }
+
+  int sync() override { return failed_ ? -1 : 0; }
+
+private:
+  bool drain()
+  {
+    streamsize n = pptr() - pbase();
+    if (n > 0 && p_target_->sputn(pbase(), n) != n) {
+      failed_ = true;
+    }
+    setp(buf_.data(), buf_.data() + buf_.size());
+    return !failed_;
+  }
+
+  streambuf * const p_target_;
+  vector<char> buf_;
+  bool failed_;
+};
+
+struct options
+{
+  options()
+    : minify(false)
+    , indent("\t")
+    , split_arrays(false)
+    , join_values(false)
+  {}
+
+  bool minify;
+  string indent;
+  bool split_arrays;
+  bool join_values;
+  vector<string> paths;
+};
+
+void usage(ostream & os)
+{
+  os << "usage: jios-fmt [options] [file ...]\n"
+        "Reformat JSON or NDJSON read from files, or standard input.\n"
+        "gzip and zstd compressed input is detected and decompressed.\n"
+        "\n"
+        "  -p, --pretty      indent output (default)\n"
+        "  -m, --minify      compact output, one top-level value per line\n"
+        "  -i, --indent N    indent by N spaces instead of a tab\n"
+        "  -n, --ndjson      write elements of top-level arrays as\n"
+        "                    separate top-level values\n"
+        "  -a, --array       write all top-level values as one array\n"
+        "  -h, --help        show this help\n"
+        "\n"
+        "--ndjson with --minify converts a JSON array to NDJSON and\n"
+        "--array with --minify converts NDJSON to a JSON array.\n";
+}
+
+bool parse_options(int argc, char ** argv, options & opts)
+{
+  for (int i = 1; i < argc; ++i) {
+    string arg = argv[i];
+    if (arg == "-p" || arg == "--pretty") {
+      opts.minify = false;
+    } else if (arg == "-m" || arg == "--minify") {
+      opts.minify = true;
+    } else if (arg == "-i" || arg == "--indent") {
+      if (++i >= argc) return false;
+      char * end = nullptr;
+      long n = strtol(argv[i], &end, 10);
+      if (*end != '\0' || n < 0 || n > 16) return false;
+      opts.indent.assign(size_t(n), ' ');
+    } else if (arg == "-n" || arg == "--ndjson") {
+      opts.split_arrays = true;
+    } else if (arg == "-a" || arg == "--array") {
+      opts.join_values = true;
+    } else if (arg == "-h" || arg == "--help") {
+      usage(cout);
+      exit(EXIT_SUCCESS);
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      return false;
+    } else {
+      opts.paths.push_back(arg);
+    }
+  }
+  return true;
+}
+
+//! Copy top-level values of jin, or elements of top-level arrays when
+//! splitting, to values returned by next_dest.
+template<class Dest>
+bool copy_values(istream & is, options const& opts, Dest next_dest)
+{
+  ijstream jin = compressed_json_in(is);
+  while (!jin.at_end()) {
+    ijvalue & v = jin.get();
+    if (!v.is_array()) {
+      jios_read(v, next_dest());
+    } else if (opts.split_arrays) {
+      ijarray ija = v.array();
+      while (!ija.at_end()) {
+        jios_read(ija.get(), next_dest());
+      }
+    } else {
+      // streamed arrays give no multiline hint
+      ijarray ija = v.array();
+      ojarray oja = next_dest().array(true);
+      while (!ija.at_end()) {
+        jios_read(ija.get(), *oja);
+      }
+      oja.terminate();
+    }
+  }
+  return !jin.fail();
+}
+
+template<class Dest>
+bool copy_inputs(options const& opts, Dest next_dest)
+{
+  if (opts.paths.empty()) {
+    if (!copy_values(cin, opts, next_dest)) {
+      cerr << "jios-fmt: invalid JSON in standard input" << endl;
+      return false;
+    }
+  }
+  for (string const& path : opts.paths) {
+    ifstream is(path, ios::binary);
+    if (!is) {
+      cerr << "jios-fmt: can not open " << path << endl;
+      return false;
+    }
+    if (!copy_values(is, opts, next_dest)) {
+      cerr << "jios-fmt: invalid JSON in " << path << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  options opts;
+  if (!parse_options(argc, argv, opts)) {
+    usage(cerr);
+    return EXIT_FAILURE;
+  }
+  ios::sync_with_stdio(false);
+
+  deferred_flush_streambuf buf(cout.rdbuf());
+  ostream os(&buf);
+  bool ok;
+  {
+    ojstream jout = (opts.minify ? lined_json_out(os)
+                                 : json_out(os, opts.indent, '\n'));
+    if (opts.join_values) {
+      ojarray oja = jout.put().array(true);
+      ok = copy_inputs(opts, [&]() -> ojvalue & { return *oja; });
+      oja.terminate();
+    } else {
+      ok = copy_inputs(opts, [&]() -> ojvalue & { return jout.put(); });
+    }
+  }
+  if (!buf.finish() || os.fail()) {
+    cerr << "jios-fmt: error writing output" << endl;
+    return EXIT_FAILURE;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
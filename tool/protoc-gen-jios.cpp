@@ -0,0 +1,437 @@
+// protoc-gen-jios: protoc plugin generating jios_read and jios_write
+// overloads for protobuf messages
+//
+// For each foo.proto, generates foo.jios.hpp and foo.jios.cpp with
+// overloads that call message accessors directly and dispatch on keys
+// with a switch, instead of the runtime reflection of
+// jios/protobuf_ij.hpp and jios/protobuf_oj.hpp. Being exact matches,
+// the generated overloads are preferred wherever their header is
+// included. JSON is the same as with reflection. Messages with enum,
+// map or group fields are left to reflection.
+//
+// Usage: protoc --plugin=protoc-gen-jios=PATH --jios_out=DIR foo.proto
+//
+// The CodeGeneratorRequest and CodeGeneratorResponse wire formats are
+// read and written directly, so only libprotobuf is needed.
+
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+
+using namespace std;
+using google::protobuf::Descriptor;
+using google::protobuf::DescriptorPool;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::FileDescriptor;
+using google::protobuf::FileDescriptorProto;
+using google::protobuf::io::ArrayInputStream;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::StringOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+
+struct generator_request
+{
+  vector<string> files_to_generate;
+  vector<FileDescriptorProto> proto_files;
+};
+
+struct generated_file
+{
+  string name;
+  string content;
+};
+
+// plugin protocol, see google/protobuf/compiler/plugin.proto
+
+bool parse_request(string const& bytes, generator_request & dest)
+{
+  ArrayInputStream raw(bytes.data(), bytes.size());
+  CodedInputStream in(&raw);
+  in.SetTotalBytesLimit(INT32_MAX);
+  while (uint32_t tag = in.ReadTag()) {
+    int field = WireFormatLite::GetTagFieldNumber(tag);
+    bool delimited = (WireFormatLite::GetTagWireType(tag)
+                      == WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+    string value;
+    if (field == 1 && delimited) {            // file_to_generate
+      if (!WireFormatLite::ReadString(&in, &value)) return false;
+      dest.files_to_generate.push_back(value);
+    } else if (field == 15 && delimited) {    // proto_file
+      if (!WireFormatLite::ReadBytes(&in, &value)) return false;
+      dest.proto_files.emplace_back();
+      if (!dest.proto_files.back().ParseFromString(value)) return false;
+    } else if (!WireFormatLite::SkipField(&in, tag)) {
+      return false;
+    }
+  }
+  return in.ConsumedEntireMessage();
+}
+
+void write_string_field(CodedOutputStream & out, int field,
+                        string const& value)
+{
+  out.WriteTag(WireFormatLite::MakeTag(
+      field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED));
+  out.WriteVarint32(value.size());
+  out.WriteString(value);
+}
+
+string make_response(string const& error,
+                     vector<generated_file> const& files)
+{
+  string ret;
+  {
+    StringOutputStream raw(&ret);
+    CodedOutputStream out(&raw);
+    if (!error.empty()) {
+      write_string_field(out, 1, error);      // error
+    }
+    // supported_features: FEATURE_PROTO3_OPTIONAL
+    out.WriteTag(WireFormatLite::MakeTag(2, WireFormatLite::WIRETYPE_VARINT));
+    out.WriteVarint64(1);
+    for (generated_file const& f : files) {
+      string file;
+      {
+        StringOutputStream file_raw(&file);
+        CodedOutputStream file_out(&file_raw);
+        write_string_field(file_out, 1, f.name);      // name
+        write_string_field(file_out, 15, f.content);  // content
+      }
+      write_string_field(out, 15, file);      // file
+    }
+  }
+  return ret;
+}
+
+// C++ names as generated by protoc
+
+set<string> const cpp_keywords = {
+  "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor",
+  "bool", "break", "case", "catch", "char", "class", "compl", "const",
+  "constexpr", "const_cast", "continue", "decltype", "default", "delete",
+  "do", "double", "dynamic_cast", "else", "enum", "explicit", "export",
+  "extern", "false", "float", "for", "friend", "goto", "if", "inline",
+  "int", "long", "mutable", "namespace", "new", "noexcept", "not",
+  "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected",
+  "public", "register", "reinterpret_cast", "return", "short", "signed",
+  "sizeof", "static", "static_assert", "static_cast", "struct", "switch",
+  "template", "this", "thread_local", "throw", "true", "try", "typedef",
+  "typeid", "typename", "union", "unsigned", "using", "virtual", "void",
+  "volatile", "wchar_t", "while", "xor", "xor_eq"
+};
+
+string field_accessor(FieldDescriptor const* field)
+{
+  string ret = field->name();
+  for (char & c : ret) { c = tolower(c); }
+  if (cpp_keywords.count(ret)) { ret += '_'; }
+  return ret;
+}
+
+string class_name(Descriptor const* msg)
+{
+  string ret = msg->name();
+  for (Descriptor const* p = msg->containing_type(); p;
+       p = p->containing_type()) {
+    ret = p->name() + "_" + ret;
+  }
+  string ns = "::";
+  for (char c : msg->file()->package()) {
+    if (c == '.') {
+      ns += "::";
+    } else {
+      ns += c;
+    }
+  }
+  if (!msg->file()->package().empty()) { ns += "::"; }
+  return ns + ret;
+}
+
+string strip_proto(string const& name)
+{
+  string const ext = ".proto";
+  if (name.size() > ext.size()
+      && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+    return name.substr(0, name.size() - ext.size());
+  }
+  return name;
+}
+
+//! Type of local variables for reading scalar fields
+string scalar_type(FieldDescriptor const* field)
+{
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:  return "int32_t";
+    case FieldDescriptor::CPPTYPE_INT64:  return "int64_t";
+    case FieldDescriptor::CPPTYPE_UINT32: return "uint32_t";
+    case FieldDescriptor::CPPTYPE_UINT64: return "uint64_t";
+    case FieldDescriptor::CPPTYPE_DOUBLE: return "double";
+    case FieldDescriptor::CPPTYPE_FLOAT:  return "float";
+    case FieldDescriptor::CPPTYPE_BOOL:   return "bool";
+    default: break;
+  }
+  return "";
+}
+
+bool is_supported(Descriptor const* msg)
+{
+  for (int i = 0; i < msg->field_count(); ++i) {
+    FieldDescriptor const* field = msg->field(i);
+    if (field->cpp_type() == FieldDescriptor::CPPTYPE_ENUM
+        || field->is_map()
+        || field->type() == FieldDescriptor::TYPE_GROUP) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void collect_messages(Descriptor const* msg, vector<Descriptor const*> & dest)
+{
+  if (msg->options().map_entry()) return;
+  if (is_supported(msg)) { dest.push_back(msg); }
+  for (int i = 0; i < msg->nested_type_count(); ++i) {
+    collect_messages(msg->nested_type(i), dest);
+  }
+}
+
+// code generation
+
+//! Condition under which reflection prints a field
+string present_condition(FieldDescriptor const* field)
+{
+  string const name = "src." + field_accessor(field);
+  if (field->is_repeated()) {
+    return name + "_size() > 0";
+  }
+  if (field->has_presence()) {
+    return "src.has_" + field_accessor(field) + "()";
+  }
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+      return "!" + name + "().empty()";
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return "has_bits(" + name + "())";
+    default:
+      break;
+  }
+  return name + "() != 0";
+}
+
+void generate_read_field(ostream & os, FieldDescriptor const* field)
+{
+  string const name = field_accessor(field);
+  bool const scalar = !scalar_type(field).empty();
+  if (field->is_repeated()) {
+    os << "      dest.clear_" << name << "();\n"
+       << "      ijarray ija = kv.array();\n"
+       << "      while (!ija.at_end()) {\n";
+    if (scalar) {
+      os << "        " << scalar_type(field) << " v = "
+         << scalar_type(field) << "();\n"
+         << "        if (ija.get().read(v)) { dest.add_" << name
+         << "(v); }\n";
+    } else {
+      os << "        ija.get().read(*dest.add_" << name << "());\n";
+    }
+    os << "      }\n";
+  } else if (scalar) {
+    os << "      " << scalar_type(field) << " v = "
+       << scalar_type(field) << "();\n"
+       << "      if (kv.read(v)) { dest.set_" << name << "(v); }\n";
+  } else {
+    os << "      kv.read(*dest.mutable_" << name << "());\n";
+  }
+}
+
+void generate_read(ostream & os, Descriptor const* msg)
+{
+  map<size_t, vector<FieldDescriptor const*>> by_length;
+  for (int i = 0; i < msg->field_count(); ++i) {
+    by_length[msg->field(i)->name().size()].push_back(msg->field(i));
+  }
+  os << "void jios_read(ijvalue & ij, " << class_name(msg) << " & dest)\n"
+     << "{\n"
+     << "  dest.Clear();\n"
+     << "  ijobject ijo = ij.object();\n"
+     << "  while (!ijo.at_end()) {\n"
+     << "    ijpair & kv = ijo.get();\n"
+     << "    boost::string_ref const key = kv.key_ref();\n"
+     << "    int field = 0;\n"
+     << "    switch (key.size()) {\n";
+  for (auto const& group : by_length) {
+    os << "      case " << group.first << ":\n";
+    for (FieldDescriptor const* field : group.second) {
+      os << "        if (key == \"" << field->name() << "\") { field = "
+         << field->number() << "; }\n";
+    }
+    os << "        break;\n";
+  }
+  os << "    }\n"
+     << "    if (field == 0) {\n"
+     << "      ij.set_failbit();\n"
+     << "      return;\n"
+     << "    }\n"
+     << "    switch (field) {\n";
+  for (int i = 0; i < msg->field_count(); ++i) {
+    FieldDescriptor const* field = msg->field(i);
+    os << "    case " << field->number() << ": {\n";
+    generate_read_field(os, field);
+    os << "      break;\n"
+       << "    }\n";
+  }
+  os << "    }\n"
+     << "  }\n"
+     << "  if (!dest.IsInitialized()) { ij.set_failbit(); }\n"
+     << "}\n\n";
+}
+
+void generate_write(ostream & os, Descriptor const* msg)
+{
+  os << "void jios_write(ojvalue & oj, " << class_name(msg)
+     << " const& src)\n"
+     << "{\n"
+     << "  int count = 0;\n";
+  for (int i = 0; i < msg->field_count(); ++i) {
+    os << "  if (" << present_condition(msg->field(i)) << ") { ++count; }\n";
+  }
+  os << "  ojobject ojo = oj.object(count > 1);\n";
+  for (int i = 0; i < msg->field_count(); ++i) {
+    FieldDescriptor const* field = msg->field(i);
+    string const name = field_accessor(field);
+    os << "  if (" << present_condition(field) << ") {\n";
+    if (field->is_repeated()) {
+      os << "    int const n = src." << name << "_size();\n"
+         << "    ojarray oja = ojo[\"" << field->name()
+         << "\"].array(n > 1);\n"
+         << "    for (int i = 0; i < n; ++i) {\n"
+         << "      oja << src." << name << "(i);\n"
+         << "    }\n"
+         << "    oja.terminate();\n";
+    } else {
+      os << "    ojo[\"" << field->name() << "\"].write(src." << name
+         << "());\n";
+    }
+    os << "  }\n";
+  }
+  os << "  ojo.terminate();\n"
+     << "}\n\n";
+}
+
+string include_guard(string const& base)
+{
+  string ret;
+  for (char c : base) {
+    ret += (isalnum(c) ? toupper(c) : '_');
+  }
+  return ret + "_JIOS_HPP";
+}
+
+void generate(FileDescriptor const* file, vector<generated_file> & dest)
+{
+  vector<Descriptor const*> messages;
+  for (int i = 0; i < file->message_type_count(); ++i) {
+    collect_messages(file->message_type(i), messages);
+  }
+  string const base = strip_proto(file->name());
+  string const header = base + ".jios.hpp";
+  string leaf = base;
+  size_t slash = leaf.rfind('/');
+  if (slash != string::npos) { leaf = leaf.substr(slash + 1); }
+
+  ostringstream hpp;
+  hpp << "// Generated by protoc-gen-jios from " << file->name()
+      << ". Do not edit.\n\n"
+      << "#ifndef " << include_guard(base) << '\n'
+      << "#define " << include_guard(base) << "\n\n"
+      << "#include \"" << leaf << ".pb.h\"\n"
+      << "#include <jios/protobuf_ij.hpp>\n"
+      << "#include <jios/protobuf_oj.hpp>\n\n"
+      << "namespace jios {\n\n\n";
+  for (Descriptor const* msg : messages) {
+    hpp << "void jios_read(ijvalue & ij, " << class_name(msg) << " & dest);\n"
+        << "void jios_write(ojvalue & oj, " << class_name(msg)
+        << " const& src);\n\n";
+  }
+  hpp << "\n} // namespace\n\n"
+      << "#endif\n";
+  dest.push_back(generated_file{header, hpp.str()});
+
+  ostringstream cpp;
+  cpp << "// Generated by protoc-gen-jios from " << file->name()
+      << ". Do not edit.\n\n"
+      << "#include \"" << leaf << ".jios.hpp\"\n\n"
+      << "#include <cstring>\n\n"
+      << "using namespace std;\n\n"
+      << "namespace jios {\n\n\n"
+      << "namespace {\n\n"
+      << "//! Whether a float field without presence differs from default\n"
+      << "template<typename T>\n"
+      << "bool has_bits(T value)\n"
+      << "{\n"
+      << "  char zero[sizeof(T)] = {};\n"
+      << "  return memcmp(&value, zero, sizeof(T)) != 0;\n"
+      << "}\n\n"
+      << "} // namespace\n\n";
+  for (Descriptor const* msg : messages) {
+    cpp << "// " << msg->full_name() << "\n\n";
+    generate_read(cpp, msg);
+    generate_write(cpp, msg);
+  }
+  cpp << "\n} // namespace\n";
+  dest.push_back(generated_file{base + ".jios.cpp", cpp.str()});
+}
+
+
+} // namespace
+
+int main()
+{
+  cin >> noskipws;
+  string bytes((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+  generator_request request;
+  if (!parse_request(bytes, request)) {
+    cerr << "protoc-gen-jios: invalid CodeGeneratorRequest on stdin\n";
+    return EXIT_FAILURE;
+  }
+
+  DescriptorPool pool;
+  string error;
+  for (FileDescriptorProto const& proto : request.proto_files) {
+    if (!pool.BuildFile(proto)) {
+      error = "protoc-gen-jios: failed to build " + proto.name();
+      break;
+    }
+  }
+  vector<generated_file> files;
+  if (error.empty()) {
+    for (string const& name : request.files_to_generate) {
+      FileDescriptor const* file = pool.FindFileByName(name);
+      if (!file) {
+        error = "protoc-gen-jios: missing descriptor of " + name;
+        break;
+      }
+      generate(file, files);
+    }
+  }
+
+  string response = make_response(error, files);
+  cout.write(response.data(), response.size());
+  cout.flush();
+  return (cout.good() ? EXIT_SUCCESS : EXIT_FAILURE);
+}